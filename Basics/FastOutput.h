@@ -0,0 +1,190 @@
+//
+// Buffered, allocation-free text output shared by the display routines of the lessons
+//
+
+#ifndef FAST_OUTPUT_H_
+#define FAST_OUTPUT_H_
+
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FAST_OUTPUT_HAS_WRITE 1
+#include <unistd.h>
+#endif
+
+namespace FastOutput
+{
+    // cout << value formats through a locale and a stream buffer, and << endl adds a flush (one system call) per line.
+    // OutputSink formats numbers with std::to_chars into one reusable block and hands a full block to the operating
+    // system with a single write(2). Nothing is allocated after construction.
+    class OutputSink
+    {
+    public:
+        static constexpr std::size_t kDefaultCapacity = 64 * 1024;
+
+        explicit OutputSink(const int fileDescriptor = 1, const std::size_t capacity = kDefaultCapacity)
+            : fileDescriptor(fileDescriptor), buffer(capacity < 64 ? 64 : capacity)
+        {
+        }
+
+        ~OutputSink() { Flush(); }
+
+        OutputSink(const OutputSink&) = delete;
+        OutputSink& operator=(const OutputSink&) = delete;
+
+        OutputSink& Write(const std::string_view text)
+        {
+            if (text.size() > buffer.size() - used)
+            {
+                Flush();
+                if (text.size() > buffer.size())
+                {
+                    WriteAll(text.data(), text.size()); // Too large to buffer, it goes out as it is
+                    return *this;
+                }
+            }
+
+            text.copy(buffer.data() + used, text.size());
+            used += text.size();
+            return *this;
+        }
+
+        OutputSink& Write(const char character) { return Write(std::string_view(&character, 1)); }
+
+        OutputSink& Write(const char* text) { return Write(std::string_view(text)); }
+
+        OutputSink& Write(const bool value) { return Write(value ? '1' : '0'); } // Like cout without boolalpha
+
+        // Integers print in decimal and floating point like cout's default precision of 6 significant digits. Unlike
+        // cout, signed and unsigned char (std::int8_t, std::uint8_t) print as numbers, not as characters: a buffer of
+        // bytes shows its values. Only plain char is a character.
+        template<typename Number>
+            requires std::is_arithmetic_v<Number> && (!std::same_as<Number, char>) && (!std::same_as<Number, bool>)
+        OutputSink& Write(const Number value)
+        {
+            constexpr std::size_t kLongestNumber = 64;
+            if (buffer.size() - used < kLongestNumber)
+            {
+                Flush();
+            }
+
+            char* first = buffer.data() + used;
+            char* last = buffer.data() + buffer.size();
+            std::to_chars_result result{};
+            if constexpr (std::is_floating_point_v<Number>)
+            {
+                result = std::to_chars(first, last, value, std::chars_format::general, 6);
+            }
+            else
+            {
+                result = std::to_chars(first, last, value);
+            }
+
+            used = static_cast<std::size_t>(result.ptr - buffer.data());
+            return *this;
+        }
+
+        // Anything else that cout can print, through a string stream: correct but not fast
+        template<typename Value>
+            requires (!std::is_arithmetic_v<Value>) && (!std::convertible_to<const Value&, std::string_view>) &&
+                     requires(std::ostream& stream, const Value& value) { stream << value; }
+        OutputSink& Write(const Value& value)
+        {
+            std::ostringstream text;
+            text << value;
+            return Write(std::string_view(text.view()));
+        }
+
+        template<typename Value>
+            requires std::convertible_to<const Value&, std::string_view> && (!std::same_as<Value, const char*>)
+        OutputSink& Write(const Value& value)
+        {
+            return Write(std::string_view(value));
+        }
+
+        // count elements followed by separator each, then terminator: what the display routines print
+        template<typename Element>
+        OutputSink& WriteElements(const Element* elements, const std::size_t count,
+                                  const std::string_view separator = " ", const std::string_view terminator = "\n")
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                Write(elements[i]);
+                Write(separator);
+            }
+
+            return Write(terminator);
+        }
+
+        // Hands the buffered text to the operating system
+        void Flush()
+        {
+            if (used > 0)
+            {
+                WriteAll(buffer.data(), used);
+                used = 0;
+            }
+        }
+
+    private:
+        int fileDescriptor;
+        std::vector<char> buffer;
+        std::size_t used = 0;
+
+        void WriteAll(const char* data, std::size_t length) const
+        {
+#ifdef FAST_OUTPUT_HAS_WRITE
+            while (length > 0)
+            {
+                const ssize_t written = ::write(fileDescriptor, data, length);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    return; // Closed pipe, full disk: the text is lost, like with a failed cout
+                }
+
+                data += written;
+                length -= static_cast<std::size_t>(written);
+            }
+#else
+            std::FILE* stream = fileDescriptor == 2 ? stderr : stdout;
+            std::fwrite(data, 1, length, stream);
+            std::fflush(stream);
+#endif
+        }
+    };
+
+    // The standard output sink of the calling thread, its block is reused by every display call
+    inline OutputSink& StandardOutput()
+    {
+        thread_local OutputSink sink(1);
+        return sink;
+    }
+
+    // Prints count elements through the standard output sink. Whatever cout still buffers is flushed first and the
+    // sink right after, so the elements appear between the cout output before and after the call.
+    template<typename Element>
+    void Display(const Element* elements, const std::size_t count, const std::string_view separator = " ",
+                 const std::string_view terminator = "\n")
+    {
+        std::cout.flush();
+        OutputSink& sink = StandardOutput();
+        sink.WriteElements(elements, count, separator, terminator);
+        sink.Flush();
+    }
+}
+
+#endif
@@ -4,6 +4,8 @@
 
 // Module 07
 
+#include "FastOutput.h"
+
 #include <cfloat>
 #include <iostream>
 
@@ -32,20 +34,16 @@ double Area(double radius, double height);
 double Volume(double radius);
 double Volume(double radius, double height);
 
+// One element per line, like cout << array[i] << endl, but formatted into one buffer and written with a single
+// system call instead of one flush per element
 void DisplayArray(int array[], int length)
 {
-    for(int i = 0; i < length; ++i)
-    {
-        cout << array[i] << endl;
-    }
+    FastOutput::Display(array, static_cast<std::size_t>(length), "\n", "");
 }
 
 void DisplayArray(char string[], int length)
 {
-    for(int i = 0; i < length; ++i)
-    {
-        cout << string[i] << endl;
-    }
+    FastOutput::Display(string, static_cast<std::size_t>(length), "\n", "");
 }
 
 // Pass by reference
@@ -366,10 +364,7 @@ void AreaByReference(double radius, double &result)
 
 void ProcessArray(double array[], const int length)
 {
-    for(int i = 0; i < length; ++i)
-    {
-        cout << array[i] << endl;
-    }
+    FastOutput::Display(array, static_cast<std::size_t>(length), "\n", "");
 }
 
 long DoubleNumber(int inputNumber)
@@ -0,0 +1,2032 @@
+//
+// MyBuffer, BufferView and the containers built on them (EytzingerIndex, BufferRope), the buffer classes
+// of the operator overloading lesson
+//
+
+#ifndef BUFFER_CLASS_H_
+#define BUFFER_CLASS_H_
+
+#include "LifecycleInstrumentation.h"
+#include "../Basics/FastOutput.h"
+#include "BufferHash.h"
+#include "BufferKernels.h"
+#include "BufferParallel.h"
+#include "BufferSort.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef MYBUFFER_INLINE_CAPACITY
+#define MYBUFFER_INLINE_CAPACITY 16
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MYBUFFER_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// mremap lets a large buffer grow in place, or move by remapping its pages instead of copying them
+#if defined(MYBUFFER_HAS_MMAP) && defined(__linux__) && defined(MREMAP_MAYMOVE)
+#define MYBUFFER_HAS_MREMAP 1
+#endif
+
+namespace BufferClass
+{
+    template<typename T, typename Allocator>
+    class MyBuffer;
+
+    template<typename T>
+    class BufferView;
+
+    // Anything that knows its length and can write its elements into contiguous memory can take part in a lazy
+    // concatenation: MyBuffer itself and nested concatenation expressions.
+    template<typename Expression>
+    concept BufferExpression = requires(const Expression& expression, typename Expression::value_type* destination)
+    {
+        { expression.GetLength() } -> std::convertible_to<std::size_t>;
+        expression.CopyTo(destination);
+    };
+
+    template<BufferExpression Lhs, BufferExpression Rhs>
+        requires std::same_as<typename Lhs::value_type, typename Rhs::value_type>
+    class BufferConcat;
+
+    template<typename Expression>
+    inline constexpr bool isBufferConcat = false;
+
+    template<typename Lhs, typename Rhs>
+    inline constexpr bool isBufferConcat<BufferConcat<Lhs, Rhs>> = true;
+
+    template<typename Expression>
+    inline constexpr bool isBufferView = false;
+
+    template<typename T>
+    inline constexpr bool isBufferView<BufferView<T>> = true;
+
+    // Lazy result of buffer + buffer. Nothing is allocated or copied until the expression is used to construct or
+    // assign a MyBuffer, at which point the final length is known and every source is copied exactly once.
+    template<BufferExpression Lhs, BufferExpression Rhs>
+        requires std::same_as<typename Lhs::value_type, typename Rhs::value_type>
+    class BufferConcat
+    {
+    private:
+        // Buffers (and ropes) are held by reference, nested expressions and views by value. That way a chain such as
+        // a + b + c never keeps a reference to the temporary produced by (a + b), nor a.Slice(0, 4) + b to the slice.
+        template<typename Operand>
+        using Stored = std::conditional_t<isBufferConcat<Operand> || isBufferView<Operand>, Operand, const Operand&>;
+
+        Stored<Lhs> lhs;
+        Stored<Rhs> rhs;
+
+    public:
+        using value_type = typename Lhs::value_type;
+
+        BufferConcat(const Lhs& left, const Rhs& right) : lhs(left), rhs(right) {}
+
+        std::size_t GetLength() const
+        {
+            return static_cast<std::size_t>(lhs.GetLength()) + static_cast<std::size_t>(rhs.GetLength());
+        }
+
+        void CopyTo(value_type* destination) const
+        {
+            lhs.CopyTo(destination);
+            rhs.CopyTo(destination + lhs.GetLength());
+        }
+    };
+
+    template<BufferExpression Lhs, BufferExpression Rhs>
+        requires std::same_as<typename Lhs::value_type, typename Rhs::value_type>
+    BufferConcat<Lhs, Rhs> operator+(const Lhs& lhs, const Rhs& rhs)
+    {
+        return BufferConcat<Lhs, Rhs>(lhs, rhs);
+    }
+
+    // Element types whose objects can be moved to a new address with a plain memcpy, leaving nothing to destroy
+    // behind. Every trivially copyable type qualifies. Specialize it for types that merely own a pointer (a
+    // unique_ptr-like handle, for example) to let MyBuffer relocate them without calling constructors and destructors.
+    template<typename T>
+    inline constexpr bool isTriviallyRelocatable = std::is_trivially_copyable_v<T>;
+
+    // Tuning of the buffer pool, read on every refill and flush. Change it before other threads start using the pool.
+    struct PoolSettings
+    {
+        std::size_t threadCacheBlocks = 64; // Free blocks a thread keeps per size class before returning half of them
+        std::size_t globalRetainedBytes = std::size_t{64} << 20; // Past this the global pool frees blocks upstream
+    };
+
+    struct PoolStats
+    {
+        std::uint64_t requests = 0; // Allocations the pool can serve (size class and alignment fit)
+        std::uint64_t hits = 0; // ... of which were served by a recycled block
+        std::uint64_t bypassed = 0; // Oversized or over-aligned allocations, forwarded to the upstream resource
+        std::size_t retainedBytes = 0; // Free bytes held by the thread caches and the global pool
+
+        double HitRate() const { return requests == 0 ? 0.0 : static_cast<double>(hits) / requests; }
+    };
+
+    // Thread-caching memory resource with power-of-two size classes (64 bytes to 1 MB).
+    // Each thread keeps a free list per size class, so a recurring allocation is a pointer pop with no lock. A thread
+    // that frees more than PoolSettings::threadCacheBlocks blocks of one class hands half of them to the global pool,
+    // and a thread whose list runs dry takes a batch back from it, so producer and consumer threads stay balanced.
+    class BufferPool final : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr std::size_t kSmallestClass = 64;
+        static constexpr std::size_t kLargestClass = std::size_t{1} << 20;
+        static constexpr std::size_t kClassCount = std::bit_width(kLargestClass / kSmallestClass);
+
+        // One pool per process: the thread caches are thread_local, they cannot belong to several pools
+        static BufferPool& Instance()
+        {
+            static BufferPool pool;
+            return pool;
+        }
+
+        PoolSettings& Settings() { return settings; }
+
+        PoolStats Stats() const
+        {
+            return PoolStats{requests.load(std::memory_order_relaxed), hits.load(std::memory_order_relaxed),
+                             bypassed.load(std::memory_order_relaxed), retainedBytes.load(std::memory_order_relaxed)};
+        }
+
+        // Frees every block parked in the global pool. Blocks in the thread caches stay until their thread exits.
+        void Trim()
+        {
+            std::lock_guard<std::mutex> lock(globalMutex);
+            for (std::size_t sizeClass = 0; sizeClass < kClassCount; ++sizeClass)
+            {
+                ReleaseUpstream(global[sizeClass], sizeClass, 0);
+            }
+        }
+
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        struct FreeList
+        {
+            FreeBlock* head = nullptr;
+            std::size_t count = 0;
+
+            void Push(void* block)
+            {
+                head = ::new (block) FreeBlock{head};
+                ++count;
+            }
+
+            void* Pop()
+            {
+                FreeBlock* block = head;
+                head = block->next;
+                --count;
+                return block;
+            }
+        };
+
+        // Hands everything back to the global pool when its thread exits
+        struct ThreadCache
+        {
+            std::array<FreeList, kClassCount> lists;
+
+            ~ThreadCache()
+            {
+                for (std::size_t sizeClass = 0; sizeClass < kClassCount; ++sizeClass)
+                {
+                    Instance().ReturnToGlobal(lists[sizeClass], sizeClass, 0);
+                }
+            }
+        };
+
+        PoolSettings settings;
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+        std::mutex globalMutex;
+        std::array<FreeList, kClassCount> global;
+        std::size_t globalBytes = 0;
+
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> bypassed{0};
+        std::atomic<std::size_t> retainedBytes{0};
+
+        BufferPool() = default;
+
+        ~BufferPool() override
+        {
+            Trim();
+        }
+
+        static ThreadCache& LocalCache()
+        {
+            thread_local ThreadCache cache;
+            return cache;
+        }
+
+        static std::size_t ClassOf(const std::size_t bytes)
+        {
+            return std::bit_width((std::max(bytes, kSmallestClass) - 1) / kSmallestClass);
+        }
+
+        static std::size_t ClassBytes(const std::size_t sizeClass) { return kSmallestClass << sizeClass; }
+
+        static bool Poolable(const std::size_t bytes, const std::size_t alignment)
+        {
+            return bytes <= kLargestClass && alignment <= alignof(std::max_align_t);
+        }
+
+        // Frees blocks of the list upstream until only keep are left. Caller holds globalMutex for the global lists.
+        void ReleaseUpstream(FreeList& list, const std::size_t sizeClass, const std::size_t keep)
+        {
+            while (list.count > keep)
+            {
+                upstream->deallocate(list.Pop(), ClassBytes(sizeClass), alignof(std::max_align_t));
+                retainedBytes.fetch_sub(ClassBytes(sizeClass), std::memory_order_relaxed);
+                if (&list == &global[sizeClass])
+                {
+                    globalBytes -= ClassBytes(sizeClass);
+                }
+            }
+        }
+
+        // Moves blocks of a thread's list to the global pool until keep are left, then enforces the global cap
+        void ReturnToGlobal(FreeList& local, const std::size_t sizeClass, const std::size_t keep)
+        {
+            if (local.count <= keep)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(globalMutex);
+            while (local.count > keep)
+            {
+                global[sizeClass].Push(local.Pop());
+                globalBytes += ClassBytes(sizeClass);
+            }
+
+            for (std::size_t victim = kClassCount; victim-- > 0 && globalBytes > settings.globalRetainedBytes;)
+            {
+                // Largest classes first: the fewest frees for the most bytes
+                const std::size_t excessBlocks =
+                    (globalBytes - settings.globalRetainedBytes + ClassBytes(victim) - 1) / ClassBytes(victim);
+                ReleaseUpstream(global[victim], victim,
+                                global[victim].count > excessBlocks ? global[victim].count - excessBlocks : 0);
+            }
+        }
+
+        // Takes up to half a thread cache worth of blocks from the global pool
+        void RefillFromGlobal(FreeList& local, const std::size_t sizeClass)
+        {
+            const std::size_t batch = std::max<std::size_t>(1, settings.threadCacheBlocks / 2);
+
+            std::lock_guard<std::mutex> lock(globalMutex);
+            while (local.count < batch && global[sizeClass].count > 0)
+            {
+                local.Push(global[sizeClass].Pop());
+                globalBytes -= ClassBytes(sizeClass);
+            }
+        }
+
+        void* do_allocate(const std::size_t bytes, const std::size_t alignment) override
+        {
+            if (!Poolable(bytes, alignment))
+            {
+                bypassed.fetch_add(1, std::memory_order_relaxed);
+                return upstream->allocate(bytes, alignment);
+            }
+
+            requests.fetch_add(1, std::memory_order_relaxed);
+            const std::size_t sizeClass = ClassOf(bytes);
+            FreeList& local = LocalCache().lists[sizeClass];
+
+            if (local.count == 0)
+            {
+                RefillFromGlobal(local, sizeClass);
+            }
+
+            if (local.count == 0)
+            {
+                return upstream->allocate(ClassBytes(sizeClass), alignof(std::max_align_t));
+            }
+
+            hits.fetch_add(1, std::memory_order_relaxed);
+            retainedBytes.fetch_sub(ClassBytes(sizeClass), std::memory_order_relaxed);
+            return local.Pop();
+        }
+
+        void do_deallocate(void* pointer, const std::size_t bytes, const std::size_t alignment) override
+        {
+            if (!Poolable(bytes, alignment))
+            {
+                upstream->deallocate(pointer, bytes, alignment);
+                return;
+            }
+
+            const std::size_t sizeClass = ClassOf(bytes);
+            FreeList& local = LocalCache().lists[sizeClass];
+            local.Push(pointer);
+            retainedBytes.fetch_add(ClassBytes(sizeClass), std::memory_order_relaxed);
+
+            if (local.count > settings.threadCacheBlocks)
+            {
+                ReturnToGlobal(local, sizeClass, settings.threadCacheBlocks / 2);
+            }
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    struct PooledTag {};
+    inline constexpr PooledTag pooled{};
+
+    // How a file is mapped into a buffer:
+    // - ReadOnly: writes through operator[] crash, SetValue ignores them.
+    // - CopyOnWrite: writes stay private to this process, the file never changes.
+    // - ReadWrite: writes go back to the file, Flush forces them to disk.
+    // - Anonymous: not a file at all, the storage a large growing buffer maps for itself (see GrowthPolicy).
+    enum class MapMode { ReadOnly, CopyOnWrite, ReadWrite, Anonymous };
+
+    // Hints forwarded to madvise so the kernel can read ahead (Sequential) or stop doing so (Random)
+    enum class AccessPattern { Normal, Sequential, Random, WillNeed };
+
+    // How Reserve, PushBack and Resize pick the new capacity once the current one is exhausted:
+    // - Factor(2.0) doubles it like most std::vector implementations, Factor(1.5) wastes less memory but reallocates
+    //   more often.
+    // - Step(n) adds n elements every time: little waste, but n pushes cost O(n^2 / step) element moves.
+    // Trivially copyable buffers whose new storage would reach remapBytes switch to an anonymous memory mapping, which
+    // mremap can then grow in place or move without copying a byte (Linux only, 0 disables it).
+    struct GrowthPolicy
+    {
+        double factor = 2.0;
+        unsigned int step = 0; // Used instead of factor when non-zero
+        std::size_t remapBytes = std::size_t{1} << 20;
+
+        static constexpr GrowthPolicy Factor(const double growthFactor) { return GrowthPolicy{growthFactor, 0}; }
+        static constexpr GrowthPolicy Step(const unsigned int elements) { return GrowthPolicy{1.0, elements}; }
+
+        // At least required, and at least one element more than current
+        unsigned int NextCapacity(const unsigned int current, const unsigned int required) const
+        {
+            const double grown = step != 0 ? static_cast<double>(current) + step
+                                           : std::max(static_cast<double>(current) * factor, current + 1.0);
+            const double limit = std::numeric_limits<unsigned int>::max();
+            return std::max(required, static_cast<unsigned int>(std::min(grown, limit)));
+        }
+    };
+
+    // Reallocation telemetry of one MyBuffer type, to tune the growth policy against a real workload
+    struct GrowthStats
+    {
+        std::uint64_t reallocations = 0; // New storage allocated and the elements moved into it
+        std::uint64_t bytesMoved = 0; // Element bytes relocated by those reallocations
+        std::uint64_t remaps = 0; // Capacity changes done by mremap, without moving any element
+    };
+
+    struct MappedFileTag {};
+    inline constexpr MappedFileTag mappedFile{};
+
+    // Sum() accumulates in the widest type of the element's kind, so long buffers do not overflow as quickly
+    template<typename T>
+    using BufferSumType = std::conditional_t<std::is_floating_point_v<T>, double,
+                                             std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>;
+
+#ifndef NDEBUG
+    // Debug builds only. The storage of a MyBuffer takes a ticket when its first view is sliced and revokes it when the
+    // elements are released; views keep the ticket and check it on every use, which is a single atomic load.
+    // A ticket is a slot and the generation the slot had when it was issued. Revoking bumps the generation and frees
+    // the slot for the next buffer, so the table only grows with the number of buffers tracked at the same time.
+    // A dangling view is missed only if its slot was reused a multiple of 4096 times before the view is used again.
+    // When all 2^20 slots are taken, new views are not tracked (ticket 0).
+    class ViewTickets
+    {
+    private:
+        static constexpr unsigned int kGenerationBits = 12;
+        static constexpr std::uint32_t kGenerationMask = (std::uint32_t{1} << kGenerationBits) - 1;
+        static constexpr std::uint32_t kSlotCount = std::uint32_t{1} << (32 - kGenerationBits);
+        static constexpr unsigned int kBlockBits = 12;
+        static constexpr std::uint32_t kBlockMask = (std::uint32_t{1} << kBlockBits) - 1;
+
+        static inline std::mutex slotMutex;
+        static inline std::vector<std::uint32_t> freeSlots; // Guarded by slotMutex
+        static inline std::uint32_t nextSlot = 1; // Slot 0 is never used, so no ticket is 0. Guarded by slotMutex.
+        // Current generation of each slot, in blocks allocated on first use and kept until the process exits
+        static inline std::array<std::atomic<std::atomic<std::uint32_t>*>, (kSlotCount >> kBlockBits)> blocks{};
+
+        // Only called for slots that Issue has handed out, so their block exists
+        static std::atomic<std::uint32_t>& Generation(const std::uint32_t slot)
+        {
+            return blocks[slot >> kBlockBits].load(std::memory_order_acquire)[slot & kBlockMask];
+        }
+
+    public:
+        static std::uint32_t Issue()
+        {
+            std::lock_guard lock(slotMutex);
+            std::uint32_t slot;
+            if (!freeSlots.empty())
+            {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else if (nextSlot < kSlotCount)
+            {
+                slot = nextSlot++;
+                std::atomic<std::atomic<std::uint32_t>*>& block = blocks[slot >> kBlockBits];
+                if (block.load(std::memory_order_relaxed) == nullptr)
+                {
+                    block.store(new std::atomic<std::uint32_t>[std::size_t{1} << kBlockBits](),
+                                std::memory_order_release);
+                }
+            }
+            else
+            {
+                return 0;
+            }
+
+            return slot << kGenerationBits | (Generation(slot).load(std::memory_order_relaxed) & kGenerationMask);
+        }
+
+        static void Revoke(const std::uint32_t ticket)
+        {
+            const std::uint32_t slot = ticket >> kGenerationBits;
+            Generation(slot).fetch_add(1, std::memory_order_release);
+            std::lock_guard lock(slotMutex);
+            freeSlots.push_back(slot);
+        }
+
+        static bool IsLive(const std::uint32_t ticket)
+        {
+            return (Generation(ticket >> kGenerationBits).load(std::memory_order_acquire) & kGenerationMask) ==
+                (ticket & kGenerationMask);
+        }
+    };
+#endif
+
+    // Non-owning window over consecutive elements of a MyBuffer, or of any contiguous memory: a pointer and a length,
+    // passed by value like std::span, which it converts to and from. Copying a view never copies an element.
+    // BufferView<const T> is the read-only view, every BufferView<T> converts to it.
+    // Debug builds (NDEBUG not defined) remember the buffer a view was sliced from and assert when the view is used
+    // after that buffer was destroyed, moved from or reallocated. The ticket that makes this work is a member in
+    // every build, so a view and a MyBuffer have the same layout with and without NDEBUG.
+    template<typename T>
+    class BufferView
+    {
+    public:
+        using value_type = std::remove_const_t<T>;
+        using element_type = T;
+
+    private:
+        template<typename>
+        friend class BufferView;
+
+        template<typename, typename>
+        friend class MyBuffer;
+
+        T* mData = nullptr;
+        unsigned int mLength = 0;
+        std::uint32_t mOwnerTicket = 0; // Of the source buffer's storage, 0 when untracked. Fills the padding.
+
+        T* Elements() const
+        {
+#ifndef NDEBUG
+            assert((mOwnerTicket == 0 || ViewTickets::IsLive(mOwnerTicket)) &&
+                   "BufferView used after its MyBuffer released the elements");
+#endif
+            return mData;
+        }
+
+        BufferView<const value_type> ReadOnly() const { return *this; }
+
+    public:
+        BufferView() = default;
+
+        BufferView(const std::span<T> elements)
+            : mData(elements.data()), mLength(static_cast<unsigned int>(elements.size()))
+        {
+        }
+
+        template<typename U>
+            requires std::same_as<const U, T> && (!std::same_as<U, T>)
+        BufferView(const BufferView<U>& view) : mData(view.mData), mLength(view.mLength), mOwnerTicket(view.mOwnerTicket)
+        {
+        }
+
+        operator std::span<T>() const { return Span(); }
+        std::span<T> Span() const { return std::span<T>(Elements(), mLength); }
+
+        T& operator[](const unsigned int index) const { return Elements()[index]; }
+
+        unsigned int GetLength() const { return mLength; }
+        T* Data() const { return Elements(); }
+
+        T* begin() const { return Elements(); }
+        T* end() const { return Elements() + mLength; }
+
+        // A narrower window of this one, clamped to its bounds like MyBuffer::Slice
+        BufferView Slice(unsigned int offset, unsigned int length) const
+        {
+            offset = std::min(offset, mLength);
+            BufferView view = *this;
+            view.mData = mData + offset;
+            view.mLength = std::min(length, mLength - offset);
+            return view;
+        }
+
+        // One to_chars per element into the reusable block of FastOutput, one write(2) for the whole line
+        void DisplayBuffer(const std::string_view separator = " ") const
+        {
+            FastOutput::Display(Elements(), mLength, separator);
+        }
+
+        bool operator==(const BufferView<const value_type>& compareTo) const
+            requires std::equality_comparable<value_type>
+        {
+            const value_type* lhs = Elements();
+            const value_type* rhs = compareTo.Elements();
+
+            if constexpr (std::is_same_v<value_type, int>)
+            {
+                return mLength == compareTo.mLength && BufferKernels::Equal(lhs, rhs, mLength);
+            }
+            else
+            {
+                return mLength == compareTo.mLength && std::equal(lhs, lhs + mLength, rhs);
+            }
+        }
+
+        // Lexicographic: the first differing element decides, otherwise the shorter view comes first
+        auto operator<=>(const BufferView<const value_type>& compareTo) const
+            requires std::three_way_comparable<value_type>
+        {
+            const value_type* lhs = Elements();
+            const value_type* rhs = compareTo.Elements();
+
+            if constexpr (std::is_same_v<value_type, int>)
+            {
+                const unsigned int common = std::min(mLength, compareTo.mLength);
+                const int result = BufferKernels::Compare(lhs, rhs, common);
+
+                if (result != 0)
+                {
+                    return result < 0 ? std::strong_ordering::less : std::strong_ordering::greater;
+                }
+
+                return mLength <=> compareTo.mLength;
+            }
+            else
+            {
+                return std::lexicographical_compare_three_way(lhs, lhs + mLength, rhs, rhs + compareTo.mLength);
+            }
+        }
+
+        // Checksums of the element bytes, to verify a transfer without comparing element by element (see BufferHash)
+        std::uint32_t Crc32c() const requires std::is_trivially_copyable_v<value_type>
+        {
+            return BufferHash::Crc32c(Elements(), sizeof(value_type) * mLength);
+        }
+
+        std::uint64_t Hash64(const std::uint64_t seed = 0) const requires std::is_trivially_copyable_v<value_type>
+        {
+            return BufferHash::Hash64(Elements(), sizeof(value_type) * mLength, seed);
+        }
+
+        // Numeric operations. Short views run on the calling thread (int with the SIMD kernels), long ones (see
+        // BufferParallel::Config) are split across threads.
+        BufferSumType<value_type> Sum() const requires std::is_arithmetic_v<value_type>
+        {
+            const value_type* elements = Elements();
+            return BufferParallel::Reduce(mLength, BufferSumType<value_type>{}, [elements](const std::size_t begin,
+                                                                                            const std::size_t end)
+            {
+                if constexpr (std::is_same_v<value_type, int>)
+                {
+                    return BufferKernels::Sum(elements + begin, end - begin);
+                }
+                else
+                {
+                    return std::accumulate(elements + begin, elements + end, BufferSumType<value_type>{});
+                }
+            }, std::plus<>());
+        }
+
+        // An empty view has no minimum or maximum: MinMax returns {max(), lowest()} of the element type for it
+        std::pair<value_type, value_type> MinMax() const requires std::is_arithmetic_v<value_type>
+        {
+            using Bounds = std::pair<value_type, value_type>;
+            const Bounds identity{std::numeric_limits<value_type>::max(), std::numeric_limits<value_type>::lowest()};
+            const value_type* elements = Elements();
+
+            return BufferParallel::Reduce(mLength, identity, [elements, &identity](const std::size_t begin,
+                                                                                   const std::size_t end)
+            {
+                Bounds bounds = identity;
+                if constexpr (std::is_same_v<value_type, int>)
+                {
+                    BufferKernels::MinMax(elements + begin, end - begin, bounds.first, bounds.second);
+                }
+                else
+                {
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        bounds.first = std::min(bounds.first, elements[i]);
+                        bounds.second = std::max(bounds.second, elements[i]);
+                    }
+                }
+                return bounds;
+            }, [](const Bounds& lhs, const Bounds& rhs)
+            {
+                return Bounds{std::min(lhs.first, rhs.first), std::max(lhs.second, rhs.second)};
+            });
+        }
+
+        value_type Min() const requires std::is_arithmetic_v<value_type> { return MinMax().first; }
+        value_type Max() const requires std::is_arithmetic_v<value_type> { return MinMax().second; }
+
+        std::size_t Count(const value_type& value) const requires std::equality_comparable<value_type>
+        {
+            const value_type* elements = Elements();
+            return BufferParallel::Reduce(mLength, std::size_t{0}, [elements, &value](const std::size_t begin,
+                                                                                      const std::size_t end)
+            {
+                if constexpr (std::is_same_v<value_type, int>)
+                {
+                    return BufferKernels::Count(elements + begin, end - begin, value);
+                }
+                else
+                {
+                    return static_cast<std::size_t>(std::count(elements + begin, elements + end, value));
+                }
+            }, std::plus<>());
+        }
+
+        // Searches. Find and FindIf return the index of the first match, GetLength() when nothing matches. They stay on
+        // the calling thread: the first match is usually near the front, and splitting the view would scan past it.
+        unsigned int Find(const value_type& value) const requires std::totally_ordered<value_type>
+        {
+            return FindIf(BufferKernels::Predicate<value_type>::Equal(value));
+        }
+
+        unsigned int FindIf(const BufferKernels::Predicate<value_type>& predicate) const
+            requires std::totally_ordered<value_type>
+        {
+            const value_type* elements = Elements();
+            if constexpr (std::is_same_v<value_type, int>)
+            {
+                return static_cast<unsigned int>(BufferKernels::FindIf(elements, mLength, predicate));
+            }
+            else
+            {
+                return static_cast<unsigned int>(std::find_if(elements, elements + mLength, predicate) - elements);
+            }
+        }
+
+        // Any other predicate, one element at a time
+        template<typename Function>
+            requires std::predicate<Function&, const value_type&>
+        unsigned int FindIf(Function predicate) const
+        {
+            const value_type* elements = Elements();
+            return static_cast<unsigned int>(std::find_if(elements, elements + mLength, predicate) - elements);
+        }
+
+        std::size_t CountIf(const BufferKernels::Predicate<value_type>& predicate) const
+            requires std::totally_ordered<value_type>
+        {
+            const value_type* elements = Elements();
+            return BufferParallel::Reduce(mLength, std::size_t{0}, [elements, &predicate](const std::size_t begin,
+                                                                                          const std::size_t end)
+            {
+                if constexpr (std::is_same_v<value_type, int>)
+                {
+                    return BufferKernels::CountIf(elements + begin, end - begin, predicate);
+                }
+                else
+                {
+                    return static_cast<std::size_t>(std::count_if(elements + begin, elements + end, predicate));
+                }
+            }, std::plus<>());
+        }
+
+        // Index of the first element not less than value in a sorted view, GetLength() when all are less. The loop has
+        // no unpredictable branch: the half to keep is picked with a conditional move, and both possible midpoints of
+        // the next step are prefetched. See EytzingerIndex for repeated searches in a large view.
+        unsigned int LowerBound(const value_type& value) const requires std::totally_ordered<value_type>
+        {
+            const value_type* first = Elements();
+            unsigned int length = mLength;
+            if (length == 0)
+            {
+                return 0;
+            }
+
+            while (length > 1)
+            {
+                const unsigned int half = length / 2;
+                if constexpr (std::is_trivially_copyable_v<value_type>)
+                {
+                    BufferKernels::Prefetch(first + half / 2);
+                    BufferKernels::Prefetch(first + half + half / 2);
+                }
+                first = first[half - 1] < value ? first + half : first;
+                length -= half;
+            }
+
+            return static_cast<unsigned int>(first - Elements()) + (*first < value ? 1 : 0);
+        }
+
+        // Copy-constructs the elements into raw storage: a view takes part in lazy concatenation like a buffer
+        void CopyTo(value_type* destination) const
+        {
+            const value_type* elements = Elements();
+            if constexpr (std::is_same_v<value_type, int>)
+            {
+                BufferKernels::Copy(destination, elements, mLength);
+            }
+            else if constexpr (std::is_trivially_copyable_v<value_type>)
+            {
+                if (mLength > 0)
+                {
+                    std::memcpy(destination, elements, sizeof(value_type) * mLength);
+                }
+            }
+            else
+            {
+                std::uninitialized_copy_n(elements, mLength, destination);
+            }
+        }
+    };
+
+    // Contiguous buffer of T. Trivially copyable element types are copied and moved to new storage with memcpy
+    // (int with the SIMD kernels); any other type is copy-constructed, moved and destroyed element by element.
+    template<typename T = int, typename Allocator = std::pmr::polymorphic_allocator<T>>
+    class MyBuffer
+    {
+    public:
+        using value_type = T;
+        using allocator_type = Allocator;
+
+        // Buffers of up to kInlineCapacity elements live inside the object itself and never touch the heap. The
+        // inline space is MYBUFFER_INLINE_CAPACITY ints whatever T is: 16 ints, 8 doubles. 0 disables the inline mode.
+        static constexpr unsigned int kInlineCapacity = MYBUFFER_INLINE_CAPACITY * sizeof(int) / sizeof(T);
+
+        // Length argument of the mapped file constructor: every element from the offset to the end of the file
+        static constexpr std::size_t kRestOfFile = std::numeric_limits<std::size_t>::max();
+
+    private:
+        using AllocatorTraits = std::allocator_traits<Allocator>;
+
+        // Constructors take the allocator through type_identity so that class template argument deduction ignores
+        // it: MyBuffer buffer(64, &arena) is a MyBuffer<int> with a resource, not a buffer of arena pointers.
+        using AllocatorArgument = std::type_identity_t<allocator_type>;
+
+        static constexpr bool kTriviallyCopyable = std::is_trivially_copyable_v<T>;
+
+        T* mNumbers = nullptr;
+        unsigned int mSize;
+        unsigned int mCapacity = 0; // Elements the current storage can hold, mSize of them are alive
+        allocator_type mAllocator; // Where heap blocks come from, the default resource unless a caller supplies one
+        void* mMapping = nullptr; // Start of the file mapping when the elements live in a mapped file
+        std::size_t mMappingLength = 0;
+        MapMode mMapMode = MapMode::ReadOnly;
+        // Debug builds take it with the first view and revoke it with the storage, which expires every view sliced from
+        // it; release builds leave it 0. Atomic so that several threads may slice the same const buffer.
+        mutable std::atomic<std::uint32_t> mViewTicket{0};
+        GrowthPolicy mGrowthPolicy;
+        alignas(T) std::byte mInline[sizeof(T) * (kInlineCapacity > 0 ? kInlineCapacity : 1)];
+
+        static inline std::atomic<std::size_t> heapAllocations{0};
+        static inline std::atomic<std::uint64_t> reallocations{0};
+        static inline std::atomic<std::uint64_t> bytesMoved{0};
+        static inline std::atomic<std::uint64_t> remaps{0};
+
+        // Views of the elements handed out so far stop being valid
+        void InvalidateViews()
+        {
+#ifndef NDEBUG
+            if (mViewTicket.load(std::memory_order_relaxed) != 0)
+            {
+                const std::uint32_t ticket = mViewTicket.exchange(0);
+                if (ticket != 0)
+                {
+                    ViewTickets::Revoke(ticket);
+                }
+            }
+#endif
+        }
+
+        template<typename View>
+        View Track(View view) const
+        {
+#ifndef NDEBUG
+            std::uint32_t ticket = mViewTicket.load();
+            if (ticket == 0)
+            {
+                const std::uint32_t fresh = ViewTickets::Issue();
+                if (mViewTicket.compare_exchange_strong(ticket, fresh))
+                {
+                    ticket = fresh;
+                }
+                else if (fresh != 0)
+                {
+                    ViewTickets::Revoke(fresh); // Another thread sliced first, ticket now holds its ticket
+                }
+            }
+
+            view.mOwnerTicket = ticket;
+#endif
+            return view;
+        }
+
+        // Untracked view of every element, the read operations of MyBuffer run on it
+        BufferView<const T> Elements() const { return BufferView<const T>(std::span<const T>(mNumbers, mSize)); }
+
+        T* InlineData() { return reinterpret_cast<T*>(mInline); }
+        const T* InlineData() const { return reinterpret_cast<const T*>(mInline); }
+
+        // Copy-constructs count elements into raw storage
+        static void CopyConstruct(T* destination, const T* source, const std::size_t count)
+        {
+            if constexpr (std::is_same_v<T, int>)
+            {
+                BufferKernels::Copy(destination, source, count);
+            }
+            else if constexpr (kTriviallyCopyable)
+            {
+                if (count > 0)
+                {
+                    std::memcpy(destination, source, sizeof(T) * count);
+                }
+            }
+            else
+            {
+                std::uninitialized_copy_n(source, count, destination);
+            }
+        }
+
+        // Overwrites count elements that are already alive
+        static void CopyAssign(T* destination, const T* source, const std::size_t count)
+        {
+            if constexpr (kTriviallyCopyable)
+            {
+                CopyConstruct(destination, source, count);
+            }
+            else
+            {
+                std::copy_n(source, count, destination);
+            }
+        }
+
+        // Moves count elements into raw storage and ends their lifetime at the source, which is left as raw storage
+        static void Relocate(T* destination, T* source, const std::size_t count)
+        {
+            if constexpr (isTriviallyRelocatable<T>)
+            {
+                if (count > 0)
+                {
+                    std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), sizeof(T) * count);
+                }
+            }
+            else
+            {
+                std::uninitialized_move_n(source, count, destination);
+                std::destroy_n(source, count);
+            }
+        }
+
+        static std::size_t PageSize()
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            static const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            return pageSize;
+#else
+            return 4096;
+#endif
+        }
+
+        // Growth beyond GrowthPolicy::remapBytes maps anonymous memory instead of asking the allocator, but only when
+        // the allocator is the default one: an arena or a pool was chosen on purpose and keeps serving the buffer.
+        bool UsesAnonymousMapping(const std::size_t capacity) const
+        {
+#ifdef MYBUFFER_HAS_MREMAP
+            return kTriviallyCopyable && mGrowthPolicy.remapBytes != 0 &&
+                sizeof(T) * capacity >= mGrowthPolicy.remapBytes && mAllocator == allocator_type();
+#else
+            (void)capacity;
+            return false;
+#endif
+        }
+
+        // Moves the elements into storage for newCapacity (>= mSize) elements: the inline array, an anonymous mapping
+        // resized with mremap, a new anonymous mapping, or a block of the allocator
+        void Reallocate(const unsigned int newCapacity)
+        {
+            const bool mapping = UsesAnonymousMapping(newCapacity);
+            const std::size_t pageSize = PageSize();
+            const std::size_t mappingLength = (sizeof(T) * newCapacity + pageSize - 1) / pageSize * pageSize;
+
+#ifdef MYBUFFER_HAS_MREMAP
+            if (mapping && mMapping != nullptr && mMapMode == MapMode::Anonymous)
+            {
+                InvalidateViews();
+                // The kernel extends the mapping where it is, or moves its pages elsewhere: no element is copied
+                void* remapped = mremap(mMapping, mMappingLength, mappingLength, MREMAP_MAYMOVE);
+                if (remapped != MAP_FAILED)
+                {
+                    mMapping = remapped;
+                    mMappingLength = mappingLength;
+                    mNumbers = static_cast<T*>(remapped);
+                    mCapacity = static_cast<unsigned int>(mappingLength / sizeof(T));
+                    remaps.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+#endif
+
+            T* newNumbers = nullptr;
+            unsigned int capacity = newCapacity;
+            void* newMapping = nullptr;
+
+            if (newCapacity <= kInlineCapacity)
+            {
+                if (mNumbers == InlineData())
+                {
+                    return; // Already there
+                }
+
+                newNumbers = InlineData();
+                capacity = kInlineCapacity;
+            }
+#ifdef MYBUFFER_HAS_MREMAP
+            else if (mapping)
+            {
+                newMapping = mmap(nullptr, mappingLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (newMapping == MAP_FAILED)
+                {
+                    newMapping = nullptr;
+                }
+                else
+                {
+                    newNumbers = static_cast<T*>(newMapping);
+                    capacity = static_cast<unsigned int>(mappingLength / sizeof(T));
+                }
+            }
+#endif
+
+            if (newNumbers == nullptr)
+            {
+                heapAllocations.fetch_add(1, std::memory_order_relaxed);
+                Lifecycle::Counters<MyBuffer>::Allocated(sizeof(T) * newCapacity);
+                newNumbers = AllocatorTraits::allocate(mAllocator, newCapacity);
+            }
+
+            if (mNumbers != nullptr)
+            {
+                Relocate(newNumbers, mNumbers, mSize);
+                ReleaseStorage();
+            }
+
+            reallocations.fetch_add(1, std::memory_order_relaxed);
+            bytesMoved.fetch_add(sizeof(T) * mSize, std::memory_order_relaxed);
+
+            mNumbers = newNumbers;
+            mCapacity = capacity;
+            mMapping = newMapping;
+            mMappingLength = newMapping != nullptr ? mappingLength : 0;
+            mMapMode = newMapping != nullptr ? MapMode::Anonymous : MapMode::ReadOnly;
+        }
+
+        // Makes room for required elements, growing by the policy so that repeated appends stay amortized O(1).
+        // A file mapping has no room to spare: its elements move to memory of the buffer's own first.
+        void Grow(const unsigned int required)
+        {
+            if (required > mCapacity || IsMapped())
+            {
+                Reallocate(mGrowthPolicy.NextCapacity(mCapacity, required));
+            }
+        }
+
+        template<typename Construct>
+        void ResizeWith(const unsigned int length, Construct construct)
+        {
+            if (length > mSize)
+            {
+                Grow(length);
+            }
+
+            if (length < mSize && !IsMapped())
+            {
+                std::destroy(mNumbers + length, mNumbers + mSize);
+            }
+
+            for (unsigned int i = mSize; i < length; ++i)
+            {
+                construct(mNumbers + i);
+            }
+
+            mSize = length;
+        }
+
+        // Raw storage for length elements: the inline array for small lengths, the allocator otherwise. Sets mCapacity.
+        T* AllocateStorage(const unsigned int length)
+        {
+            if (length <= kInlineCapacity)
+            {
+                mCapacity = kInlineCapacity;
+                return InlineData();
+            }
+
+            mCapacity = length;
+            heapAllocations.fetch_add(1, std::memory_order_relaxed);
+            Lifecycle::Counters<MyBuffer>::Allocated(sizeof(T) * length);
+            return AllocatorTraits::allocate(mAllocator, length);
+        }
+
+        // Default-initializes the elements like new T[] would: class types run their constructor, ints stay as they are
+        void ConstructElements()
+        {
+            if constexpr (!std::is_trivially_default_constructible_v<T>)
+            {
+                std::uninitialized_default_construct_n(mNumbers, mSize);
+            }
+        }
+
+        void DestroyElements()
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                if (mNumbers != nullptr)
+                {
+                    std::destroy_n(mNumbers, mSize);
+                }
+            }
+        }
+
+        // mCapacity must still describe the block being released, the allocator needs it back
+        void ReleaseStorage()
+        {
+            InvalidateViews();
+
+            if (mMapping != nullptr)
+            {
+#ifdef MYBUFFER_HAS_MMAP
+                munmap(mMapping, mMappingLength);
+#endif
+                mMapping = nullptr;
+                mMappingLength = 0;
+            }
+            else if (IsOnHeap())
+            {
+                AllocatorTraits::deallocate(mAllocator, mNumbers, mCapacity);
+            }
+
+            mNumbers = nullptr;
+            mCapacity = 0;
+        }
+
+        void Release()
+        {
+            DestroyElements();
+            ReleaseStorage();
+        }
+
+        // Takes over rhs' elements: a heap block is stolen when both buffers share an allocator, inline elements (or
+        // a block owned by a different allocator) have to be relocated
+        void StealFrom(MyBuffer& rhs)
+        {
+            mSize = rhs.mSize;
+
+            if (rhs.IsOnHeap() && rhs.mAllocator != mAllocator)
+            {
+                mNumbers = AllocateStorage(mSize);
+                Relocate(mNumbers, rhs.mNumbers, mSize);
+                rhs.ReleaseStorage();
+                rhs.mSize = 0;
+                return;
+            }
+
+            if (rhs.IsOnHeap() || rhs.mMapping != nullptr)
+            {
+                mNumbers = rhs.mNumbers; // We take ownership of the memory pointer! No copy, we just take it
+                mCapacity = rhs.mCapacity;
+            }
+            else if (rhs.mNumbers != nullptr)
+            {
+                mNumbers = InlineData();
+                mCapacity = kInlineCapacity;
+                Relocate(mNumbers, rhs.mNumbers, mSize);
+            }
+
+            mMapping = rhs.mMapping;
+            mMappingLength = rhs.mMappingLength;
+            mMapMode = rhs.mMapMode;
+
+            // Clear source resources after moving them to avoid any issues
+            rhs.InvalidateViews();
+            rhs.mSize = 0;
+            rhs.mCapacity = 0;
+            rhs.mNumbers = nullptr;
+            rhs.mMapping = nullptr;
+            rhs.mMappingLength = 0;
+        }
+
+    public:
+        explicit MyBuffer(const unsigned int length, const AllocatorArgument& allocator = allocator_type())
+            : mSize(length), mAllocator(allocator)
+        {
+            mNumbers = AllocateStorage(mSize); // Allocate memory
+            ConstructElements();
+            Lifecycle::Counters<MyBuffer>::Constructed();
+        }
+
+        // Opt-in recycling: heap blocks come from and go back to the thread-caching BufferPool
+        MyBuffer(PooledTag, const unsigned int length)
+            requires std::same_as<Allocator, std::pmr::polymorphic_allocator<T>>
+            : MyBuffer(length, allocator_type(&BufferPool::Instance()))
+        {
+        }
+
+        // Maps a file of raw elements instead of copying it: pages are read on demand the first time they are
+        // touched. On failure (missing file, size not a multiple of sizeof(T), no mmap on this platform) the buffer is
+        // empty and IsMapped() returns false. MapFile reports the same thing through std::optional.
+        MyBuffer(MappedFileTag, const char* path, const MapMode mode = MapMode::ReadOnly)
+            requires std::is_trivially_copyable_v<T>
+            : MyBuffer(mappedFile, path, mode, 0, kRestOfFile)
+        {
+        }
+
+        // Maps only length elements starting byteOffset bytes into the file, e.g. the payload behind a file header.
+        // The offset does not have to be page aligned, only aligned for T; kRestOfFile maps everything after it.
+        MyBuffer(MappedFileTag, const char* path, const MapMode mode, const std::size_t byteOffset,
+                 const std::size_t length)
+            requires std::is_trivially_copyable_v<T>
+            : mSize(0), mMapMode(mode)
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            const int fileDescriptor = open(path, mode == MapMode::ReadWrite ? O_RDWR : O_RDONLY);
+            if (fileDescriptor < 0)
+            {
+                return;
+            }
+
+            struct stat fileInfo{};
+            if (fstat(fileDescriptor, &fileInfo) == 0 && byteOffset % alignof(T) == 0 &&
+                byteOffset < static_cast<std::size_t>(fileInfo.st_size))
+            {
+                const std::size_t available = static_cast<std::size_t>(fileInfo.st_size) - byteOffset;
+                const bool wholeRest = length == kRestOfFile;
+                const std::size_t count = wholeRest ? available / sizeof(T) : length;
+
+                if (count > 0 && count <= std::numeric_limits<unsigned int>::max() &&
+                    (wholeRest ? available % sizeof(T) == 0 : count <= available / sizeof(T)))
+                {
+                    // mmap only accepts page-aligned offsets: map from the page that holds the first element
+                    const std::size_t pageOffset = byteOffset % PageSize();
+                    const std::size_t mappingLength = pageOffset + count * sizeof(T);
+                    const int protection = mode == MapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+                    const int flags = mode == MapMode::ReadWrite ? MAP_SHARED : MAP_PRIVATE;
+                    void* mapping = mmap(nullptr, mappingLength, protection, flags, fileDescriptor,
+                                         static_cast<off_t>(byteOffset - pageOffset));
+
+                    if (mapping != MAP_FAILED)
+                    {
+                        mMapping = mapping;
+                        mMappingLength = mappingLength;
+                        mNumbers = reinterpret_cast<T*>(static_cast<std::byte*>(mapping) + pageOffset);
+                        mSize = static_cast<unsigned int>(count);
+                        mCapacity = mSize;
+                    }
+                }
+            }
+
+            close(fileDescriptor); // The mapping keeps the file alive on its own
+#else
+            (void)path;
+            (void)byteOffset;
+            (void)length;
+#endif
+            Lifecycle::Counters<MyBuffer>::Constructed();
+        }
+
+        static std::optional<MyBuffer> MapFile(const char* path, const MapMode mode = MapMode::ReadOnly)
+            requires std::is_trivially_copyable_v<T>
+        {
+            MyBuffer mapped(mappedFile, path, mode);
+            if (!mapped.IsMapped())
+            {
+                return std::nullopt;
+            }
+
+            return mapped;
+        }
+
+        virtual ~MyBuffer()
+        {
+            Lifecycle::Counters<MyBuffer>::Destroyed();
+            Release(); // Free allocated memory
+        }
+
+        // Like the pmr containers, a plain copy does not inherit the source's resource, it uses the default one.
+        // Pass a resource explicitly to copy into an arena or a pool.
+        MyBuffer(const MyBuffer& rhs)
+            : MyBuffer(rhs, AllocatorTraits::select_on_container_copy_construction(rhs.mAllocator))
+        {
+        }
+
+        MyBuffer(const MyBuffer& rhs, const AllocatorArgument& allocator)
+            : mSize(rhs.mSize), mAllocator(allocator), mGrowthPolicy(rhs.mGrowthPolicy)
+        {
+            mNumbers = AllocateStorage(mSize);
+            try
+            {
+                CopyConstruct(this->mNumbers, rhs.mNumbers, mSize);
+            }
+            catch (...)
+            {
+                // The destructor does not run for a constructor that throws, and CopyConstruct already destroyed the
+                // elements it had made
+                ReleaseStorage();
+                throw;
+            }
+
+            Lifecycle::Counters<MyBuffer>::Copied();
+        }
+
+        // A move keeps the source's resource, so the heap block can always be stolen. Only inline elements move.
+        MyBuffer(MyBuffer&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : mAllocator(rhs.mAllocator), mGrowthPolicy(rhs.mGrowthPolicy)
+        {
+            Lifecycle::Counters<MyBuffer>::Moved();
+            StealFrom(rhs);
+        }
+
+        // Moving into a different resource relocates the elements, the block cannot change owners
+        MyBuffer(MyBuffer&& rhs, const AllocatorArgument& allocator)
+            : mAllocator(allocator), mGrowthPolicy(rhs.mGrowthPolicy)
+        {
+            Lifecycle::Counters<MyBuffer>::Moved();
+            StealFrom(rhs);
+        }
+
+        // The copy is made in new storage before the old elements are released, so an element copy or an allocation
+        // that throws leaves this buffer as it was
+        MyBuffer& operator=(const MyBuffer& rhs)
+        {
+            if (this != &rhs)
+            {
+                MyBuffer copy(rhs, mAllocator);
+                Release();
+                StealFrom(copy);
+            }
+
+            return *this;
+        }
+
+        // Assignments keep this buffer's resource. Not noexcept: when the resources differ the elements are copied.
+        // Assigning a moved-from buffer empties this one.
+        MyBuffer& operator=(MyBuffer&& rhs)
+        {
+            if (this != &rhs) // Ensure it's not ourselves
+            {
+                Lifecycle::Counters<MyBuffer>::Moved();
+                Release();
+                if (rhs.mNumbers != nullptr)
+                {
+                    StealFrom(rhs);
+                }
+                else
+                {
+                    mSize = 0;
+                    mNumbers = AllocateStorage(0); // The empty inline state of a new MyBuffer(0)
+                }
+            }
+
+            return *this;
+        }
+
+        // Materialize a lazy concatenation: a single allocation of the final length and one bulk copy per source.
+        template<typename Lhs, typename Rhs>
+            requires std::same_as<typename BufferConcat<Lhs, Rhs>::value_type, T>
+        MyBuffer(const BufferConcat<Lhs, Rhs>& concatenation, const AllocatorArgument& allocator = allocator_type())
+            : mSize(static_cast<unsigned int>(concatenation.GetLength())), mAllocator(allocator)
+        {
+            Lifecycle::Counters<MyBuffer>::Constructed();
+            mNumbers = AllocateStorage(mSize);
+            concatenation.CopyTo(mNumbers);
+        }
+
+        template<typename Lhs, typename Rhs>
+            requires std::same_as<typename BufferConcat<Lhs, Rhs>::value_type, T>
+        MyBuffer& operator=(const BufferConcat<Lhs, Rhs>& concatenation)
+        {
+            // Fill the new storage before releasing the old one, so buffer = buffer + other still reads valid memory.
+            // A small result is staged on the stack first, as it will end up in the inline array it may be read from.
+            const unsigned int newSize = static_cast<unsigned int>(concatenation.GetLength());
+
+            if (newSize <= kInlineCapacity)
+            {
+                alignas(T) std::byte staged[sizeof(T) * (kInlineCapacity > 0 ? kInlineCapacity : 1)];
+                T* stagedElements = reinterpret_cast<T*>(staged);
+                concatenation.CopyTo(stagedElements);
+                Release();
+                mNumbers = InlineData();
+                mCapacity = kInlineCapacity;
+                Relocate(mNumbers, stagedElements, newSize);
+            }
+            else
+            {
+                heapAllocations.fetch_add(1, std::memory_order_relaxed);
+                Lifecycle::Counters<MyBuffer>::Allocated(sizeof(T) * newSize);
+                T* newNumbers = AllocatorTraits::allocate(mAllocator, newSize);
+                concatenation.CopyTo(newNumbers);
+                Release();
+                mNumbers = newNumbers;
+                mCapacity = newSize;
+            }
+
+            mSize = newSize;
+            return *this;
+        }
+
+        // Number of heap blocks allocated by every MyBuffer of this type so far. Inline buffers do not count.
+        static std::size_t HeapAllocationCount()
+        {
+            return heapAllocations.load(std::memory_order_relaxed);
+        }
+
+        allocator_type get_allocator() const { return mAllocator; }
+
+        std::pmr::memory_resource* GetResource() const
+            requires std::same_as<Allocator, std::pmr::polymorphic_allocator<T>>
+        {
+            return mAllocator.resource();
+        }
+
+        bool IsOnHeap() const
+        {
+            return mNumbers != nullptr && mNumbers != InlineData() && mMapping == nullptr;
+        }
+
+        // True for file mappings. The anonymous mapping of a large growing buffer is its own memory, not a file.
+        bool IsMapped() const { return mMapping != nullptr && mMapMode != MapMode::Anonymous; }
+
+        // Writes the dirty pages of a ReadWrite mapping back to the file. synchronous waits for the disk, otherwise
+        // the write is only scheduled. Returns false for any other kind of buffer or when msync fails.
+        bool Flush(const bool synchronous = true)
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            if (IsMapped() && mMapMode == MapMode::ReadWrite)
+            {
+                return msync(mMapping, mMappingLength, synchronous ? MS_SYNC : MS_ASYNC) == 0;
+            }
+#else
+            (void)synchronous;
+#endif
+            return false;
+        }
+
+        bool Sync() { return Flush(true); }
+
+        bool Advise(const AccessPattern pattern)
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            if (IsMapped())
+            {
+                int advice = MADV_NORMAL;
+                switch (pattern)
+                {
+                    case AccessPattern::Sequential:
+                        advice = MADV_SEQUENTIAL;
+                        break;
+                    case AccessPattern::Random:
+                        advice = MADV_RANDOM;
+                        break;
+                    case AccessPattern::WillNeed:
+                        advice = MADV_WILLNEED;
+                        break;
+                    case AccessPattern::Normal:
+                        break;
+                }
+
+                return madvise(mMapping, mMappingLength, advice) == 0;
+            }
+#else
+            (void)pattern;
+#endif
+            return false;
+        }
+
+        // Eager, pairwise concatenation. This is what operator+ used to do: every call allocates a temporary of the
+        // combined length and copies both sides, so a chain of N buffers allocates N - 1 times.
+        MyBuffer Concatenate(const MyBuffer& rhsToAppend) const
+        {
+            MyBuffer temp(this->mSize + rhsToAppend.mSize, mAllocator); // New combined length
+
+            CopyAssign(temp.mNumbers, this->mNumbers, this->mSize);
+            CopyAssign(temp.mNumbers + this->mSize, rhsToAppend.mNumbers, rhsToAppend.mSize);
+
+            return temp;
+        }
+
+        T& operator[](const unsigned int index)
+        {
+            return mNumbers[index];
+        }
+
+        const T& operator[](const unsigned int index) const
+        {
+            return mNumbers[index];
+        }
+
+        void SetValue(const unsigned int index, const T& value)
+        {
+            if(index < mSize && !(IsMapped() && mMapMode == MapMode::ReadOnly)) // Read-only pages cannot be written
+            {
+                *(mNumbers + index) = value; // + will move pointer forward by n index
+            }
+        }
+
+        void DisplayBuffer(const std::string_view separator = " ") const
+        {
+            Elements().DisplayBuffer(separator);
+        }
+
+        void Fill(const T& value)
+        {
+            if constexpr (std::is_same_v<T, int>)
+            {
+                BufferKernels::Fill(mNumbers, value, mSize);
+            }
+            else
+            {
+                std::fill_n(mNumbers, mSize, value);
+            }
+        }
+
+        bool operator==(const MyBuffer& compareTo) const requires std::equality_comparable<T>
+        {
+            return Elements() == compareTo.Elements();
+        }
+
+        // Lexicographic: the first differing element decides, otherwise the shorter buffer comes first
+        auto operator<=>(const MyBuffer& compareTo) const requires std::three_way_comparable<T>
+        {
+            return Elements() <=> compareTo.Elements();
+        }
+
+        unsigned int GetLength() const { return mSize; }
+
+        T* Data() { return mNumbers; }
+        const T* Data() const { return mNumbers; }
+
+        // Views of part of the buffer that copy nothing: Slice(offset, length) is clamped to the buffer, View() covers
+        // all of it. A view is valid until the buffer is destroyed, moved from or reallocated (PushBack, Reserve,
+        // Resize, ShrinkToFit, assignments). Debug builds assert when a view is used after that.
+        BufferView<T> Slice(const unsigned int offset, const unsigned int length)
+        {
+            return Track(BufferView<T>(std::span<T>(mNumbers, mSize))).Slice(offset, length);
+        }
+
+        BufferView<const T> Slice(const unsigned int offset, const unsigned int length) const
+        {
+            return Track(Elements()).Slice(offset, length);
+        }
+
+        BufferView<T> View() { return Slice(0, mSize); }
+        BufferView<const T> View() const { return Slice(0, mSize); }
+
+        std::span<T> Span() { return View(); }
+        std::span<const T> Span() const { return View(); }
+
+        // Capacity management. Like std::vector, a buffer keeps spare room after its elements so that PushBack only
+        // reallocates once in a while. Any reallocation invalidates pointers and references to the elements.
+        unsigned int GetCapacity() const { return mCapacity; }
+
+        GrowthPolicy GetGrowthPolicy() const { return mGrowthPolicy; }
+        void SetGrowthPolicy(const GrowthPolicy& policy) { mGrowthPolicy = policy; }
+
+        // Exactly capacity elements of room, if that is more than what the buffer has. A file mapping cannot grow:
+        // reserving room in one copies its elements into memory of the buffer's own.
+        void Reserve(const unsigned int capacity)
+        {
+            if (capacity > mCapacity || (IsMapped() && capacity > mSize))
+            {
+                Reallocate(capacity);
+            }
+        }
+
+        void PushBack(const T& value)
+        {
+            if (mSize == mCapacity || IsMapped())
+            {
+                T copy(value); // value may live in the storage the reallocation is about to free
+                Grow(mSize + 1);
+                std::construct_at(mNumbers + mSize, std::move(copy));
+            }
+            else
+            {
+                std::construct_at(mNumbers + mSize, value);
+            }
+
+            ++mSize;
+        }
+
+        void PushBack(T&& value)
+        {
+            if (mSize == mCapacity || IsMapped())
+            {
+                T moved(std::move(value));
+                Grow(mSize + 1);
+                std::construct_at(mNumbers + mSize, std::move(moved));
+            }
+            else
+            {
+                std::construct_at(mNumbers + mSize, std::move(value));
+            }
+
+            ++mSize;
+        }
+
+        // New elements are default-initialized like those of the constructor, or copies of value
+        void Resize(const unsigned int length)
+        {
+            ResizeWith(length, [](T* element) { std::uninitialized_default_construct_n(element, 1); });
+        }
+
+        void Resize(const unsigned int length, const T& value)
+        {
+            const T copy(value); // value may live in the storage Resize reallocates
+            ResizeWith(length, [&copy](T* element) { std::construct_at(element, copy); });
+        }
+
+        // Gives the spare capacity back: small buffers return to the inline array, mappings shrink with mremap
+        void ShrinkToFit()
+        {
+            if (mCapacity > mSize && !IsMapped())
+            {
+                Reallocate(mSize);
+            }
+        }
+
+        static GrowthStats GrowthTelemetry()
+        {
+            return GrowthStats{reallocations.load(std::memory_order_relaxed),
+                               bytesMoved.load(std::memory_order_relaxed), remaps.load(std::memory_order_relaxed)};
+        }
+
+        static void ResetGrowthTelemetry()
+        {
+            reallocations = 0;
+            bytesMoved = 0;
+            remaps = 0;
+        }
+
+        // Numeric operations, see BufferView. Long buffers are split across threads.
+        BufferSumType<T> Sum() const requires std::is_arithmetic_v<T> { return Elements().Sum(); }
+        std::pair<T, T> MinMax() const requires std::is_arithmetic_v<T> { return Elements().MinMax(); }
+        T Min() const requires std::is_arithmetic_v<T> { return Elements().Min(); }
+        T Max() const requires std::is_arithmetic_v<T> { return Elements().Max(); }
+        std::size_t Count(const T& value) const requires std::equality_comparable<T> { return Elements().Count(value); }
+
+        // Searches, see BufferView. Not found is GetLength().
+        unsigned int Find(const T& value) const requires std::totally_ordered<T> { return Elements().Find(value); }
+        unsigned int FindIf(const BufferKernels::Predicate<T>& predicate) const requires std::totally_ordered<T>
+        {
+            return Elements().FindIf(predicate);
+        }
+
+        template<typename Function>
+            requires std::predicate<Function&, const T&>
+        unsigned int FindIf(Function predicate) const
+        {
+            return Elements().FindIf(std::move(predicate));
+        }
+
+        std::size_t CountIf(const BufferKernels::Predicate<T>& predicate) const requires std::totally_ordered<T>
+        {
+            return Elements().CountIf(predicate);
+        }
+
+        unsigned int LowerBound(const T& value) const requires std::totally_ordered<T>
+        {
+            return Elements().LowerBound(value);
+        }
+
+        std::uint32_t Crc32c() const requires std::is_trivially_copyable_v<T> { return Elements().Crc32c(); }
+        std::uint64_t Hash64(const std::uint64_t seed = 0) const requires std::is_trivially_copyable_v<T>
+        {
+            return Elements().Hash64(seed);
+        }
+
+        // Replaces every element with function(element). function may run on several threads at once.
+        template<typename Function>
+        void Transform(Function function)
+        {
+            BufferParallel::ForEachRange(mSize, [this, &function](const std::size_t begin, const std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    mNumbers[i] = function(mNumbers[i]);
+                }
+            });
+        }
+
+        // Replaces every element with the sum of itself and all the elements before it. Integer overflow wraps around.
+        void InclusiveScan() requires std::is_arithmetic_v<T>
+        {
+            auto wrappingAdd = [](const T lhs, const T rhs)
+            {
+                if constexpr (std::is_integral_v<T>)
+                {
+                    using Unsigned = std::make_unsigned_t<T>;
+                    return static_cast<T>(static_cast<Unsigned>(lhs) + static_cast<Unsigned>(rhs));
+                }
+                else
+                {
+                    return static_cast<T>(lhs + rhs);
+                }
+            };
+
+            auto scanRange = [this, &wrappingAdd](const std::size_t begin, const std::size_t end)
+            {
+                for (std::size_t i = begin + 1; i < end; ++i)
+                {
+                    mNumbers[i] = wrappingAdd(mNumbers[i - 1], mNumbers[i]);
+                }
+            };
+
+            if (!BufferParallel::IsParallel(mSize))
+            {
+                scanRange(0, mSize);
+                return;
+            }
+
+            // Two passes: scan every chunk on its own, then add the total of all previous chunks to each chunk
+            const std::size_t chunks = BufferParallel::ChunkCount(mSize);
+            std::vector<T> chunkTotals(chunks, T{});
+            BufferParallel::ForEachChunk(mSize, [&](const std::size_t chunk, const std::size_t begin,
+                                                    const std::size_t end)
+            {
+                scanRange(begin, end);
+                chunkTotals[chunk] = end > begin ? mNumbers[end - 1] : T{};
+            });
+
+            std::vector<T> chunkOffsets(chunks, T{});
+            for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+            {
+                chunkOffsets[chunk] = wrappingAdd(chunkOffsets[chunk - 1], chunkTotals[chunk - 1]);
+            }
+
+            BufferParallel::ForEachChunk(mSize, [&](const std::size_t chunk, const std::size_t begin,
+                                                    const std::size_t end)
+            {
+                for (std::size_t i = begin; i < end && chunk > 0; ++i)
+                {
+                    mNumbers[i] = wrappingAdd(mNumbers[i], chunkOffsets[chunk]);
+                }
+            });
+        }
+
+        // Sorts the elements in place: a sorting network under 32 elements, LSD radix sort for 32- and 64-bit integers
+        // in the default order, std::sort otherwise, and chunks sorted on every thread then merged for long buffers.
+        template<typename Compare = std::less<>>
+        void Sort(Compare compare = {})
+        {
+            BufferSort::Sort(mNumbers, mSize, compare, false);
+        }
+
+        // Like Sort, but elements that compare equal keep their order
+        template<typename Compare = std::less<>>
+        void StableSort(Compare compare = {})
+        {
+            BufferSort::Sort(mNumbers, mSize, compare, true);
+        }
+
+        // Indices that would sort the buffer, which itself stays as it is: buffer[order[0]] is the smallest element
+        template<typename Compare = std::less<>>
+        MyBuffer<unsigned int> ArgSort(Compare compare = {}) const
+        {
+            MyBuffer<unsigned int> order(mSize);
+            BufferSort::ArgSort(mNumbers, order.Data(), mSize, compare);
+            return order;
+        }
+
+        // Copy-constructs every element into destination, used when a concatenation is materialized. destination is
+        // raw storage for GetLength() elements (any memory will do for trivially copyable types).
+        void CopyTo(T* destination) const
+        {
+            CopyConstruct(destination, mNumbers, mSize);
+        }
+    };
+
+    // MyBuffer all(doublesA + doublesB) deduces MyBuffer<double> from the expression
+    template<typename Lhs, typename Rhs>
+    MyBuffer(const BufferConcat<Lhs, Rhs>&) -> MyBuffer<typename BufferConcat<Lhs, Rhs>::value_type>;
+
+    // Sorted keys in Eytzinger (breadth-first heap) order for repeated LowerBound calls. A binary search over a sorted
+    // array jumps across the whole array in its first steps, so every step is a cache miss. Here the children of node
+    // k are 2k and 2k + 1, the first levels share a few cache lines, and the 16 descendants four levels down sit next
+    // to each other, so one prefetch per step hides most of the memory latency.
+    template<typename T = int>
+    class EytzingerIndex
+    {
+    private:
+        MyBuffer<T> layout;            // layout[0] is unused, the root is layout[1]
+        MyBuffer<unsigned int> order;  // order[k] is the position in the sorted keys of layout[k]
+        unsigned int length = 0;
+
+        // In-order traversal of the implicit tree visits the nodes in sorted order
+        unsigned int Place(const T* sorted, unsigned int next, const unsigned int node)
+        {
+            if (node <= length)
+            {
+                next = Place(sorted, next, 2 * node);
+                layout[node] = sorted[next];
+                order[node] = next++;
+                next = Place(sorted, next, 2 * node + 1);
+            }
+
+            return next;
+        }
+
+    public:
+        // sorted must be in ascending order
+        explicit EytzingerIndex(const std::span<const T> sorted)
+            : layout(static_cast<unsigned int>(sorted.size() + 1)), order(static_cast<unsigned int>(sorted.size() + 1)),
+              length(static_cast<unsigned int>(sorted.size()))
+        {
+            Place(sorted.data(), 0, 1);
+        }
+
+        template<typename Allocator>
+        explicit EytzingerIndex(const MyBuffer<T, Allocator>& sorted)
+            : EytzingerIndex(std::span<const T>(sorted.Data(), sorted.GetLength()))
+        {
+        }
+
+        unsigned int GetLength() const { return length; }
+
+        // Same result as BufferView::LowerBound on the sorted keys: the sorted position, GetLength() when none
+        unsigned int LowerBound(const T& value) const
+        {
+            const T* nodes = layout.Data();
+            unsigned int node = 1;
+            while (node <= length)
+            {
+                BufferKernels::Prefetch(nodes + std::min(16 * node, length)); // Four levels down
+                node = 2 * node + (nodes[node] < value ? 1 : 0);
+            }
+
+            // The path ends below a leaf. Undo the right turns taken after the last left turn, which was at the answer.
+            node >>= std::countr_one(node) + 1;
+            return node == 0 ? length : order[node];
+        }
+    };
+
+    // Segmented buffer for append-heavy work such as accumulating log samples. The elements live in a list of
+    // MyBuffer chunks, so appending never moves what is already stored: re-concatenating a contiguous MyBuffer
+    // copies everything each time, which makes n appends cost O(n^2), and even PushBack moves it all on every growth.
+    class BufferRope
+    {
+    public:
+        using value_type = int;
+
+        static constexpr unsigned int kChunkLength = 4096; // Capacity of the chunks created for single appends
+
+        class ConstIterator
+        {
+        private:
+            const BufferRope* rope = nullptr;
+            std::size_t chunk = 0;
+            const int* current = nullptr;
+            const int* chunkEnd = nullptr;
+
+            void EnterChunk()
+            {
+                // Skip empty chunks so current always points at an element, or is null at the end
+                while (chunk < rope->chunks.size() && rope->ChunkLength(chunk) == 0)
+                {
+                    ++chunk;
+                }
+
+                if (chunk < rope->chunks.size())
+                {
+                    current = rope->chunks[chunk].Data();
+                    chunkEnd = current + rope->ChunkLength(chunk);
+                }
+                else
+                {
+                    current = chunkEnd = nullptr;
+                }
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = int;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const int*;
+            using reference = const int&;
+
+            ConstIterator() = default;
+
+            ConstIterator(const BufferRope* owner, const std::size_t startChunk) : rope(owner), chunk(startChunk)
+            {
+                EnterChunk();
+            }
+
+            reference operator*() const { return *current; }
+            pointer operator->() const { return current; }
+
+            // Within a chunk this is a plain pointer increment, which keeps the walk sequential in memory
+            ConstIterator& operator++()
+            {
+                if (++current == chunkEnd)
+                {
+                    ++chunk;
+                    EnterChunk();
+                }
+
+                return *this;
+            }
+
+            ConstIterator operator++(int)
+            {
+                ConstIterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const ConstIterator& compareTo) const { return current == compareTo.current; }
+        };
+
+        BufferRope() = default;
+
+        void Append(const int value)
+        {
+            if (chunks.empty() || tailUsed == chunks.back().GetLength())
+            {
+                AddChunk(MyBuffer<>(kChunkLength), 0);
+            }
+
+            chunks.back()[tailUsed++] = value;
+            ++length;
+        }
+
+        // Small buffers are copied into the free space of the tail chunk, larger ones get a chunk of their own
+        void Append(const MyBuffer<>& buffer)
+        {
+            const unsigned int appended = buffer.GetLength();
+
+            if (!chunks.empty() && chunks.back().GetLength() - tailUsed >= appended)
+            {
+                BufferKernels::Copy(chunks.back().Data() + tailUsed, buffer.Data(), appended);
+                tailUsed += appended;
+                length += appended;
+                return;
+            }
+
+            MyBuffer<> chunk(std::max(appended, kChunkLength));
+            BufferKernels::Copy(chunk.Data(), buffer.Data(), appended);
+            AddChunk(std::move(chunk), appended);
+        }
+
+        // O(1): the buffer becomes a chunk, its elements are not copied
+        void Append(MyBuffer<>&& buffer)
+        {
+            const unsigned int appended = buffer.GetLength();
+            AddChunk(std::move(buffer), appended);
+        }
+
+        // Takes over every chunk of rhs, whose elements are never copied. rope.Append(std::move(rope)) cannot take
+        // its own chunks, so it appends a copy of each instead and doubles the rope.
+        void Append(BufferRope&& rhs)
+        {
+            if (&rhs == this)
+            {
+                const std::size_t chunkCount = chunks.size();
+                for (std::size_t i = 0; i < chunkCount; ++i)
+                {
+                    const auto used = static_cast<unsigned int>(ChunkLength(i));
+                    if (used > 0)
+                    {
+                        MyBuffer<> copy(used);
+                        BufferKernels::Copy(copy.Data(), chunks[i].Data(), used);
+                        AddChunk(std::move(copy), used);
+                    }
+                }
+                return;
+            }
+
+            for (std::size_t i = 0; i < rhs.chunks.size(); ++i)
+            {
+                AddChunk(std::move(rhs.chunks[i]), rhs.ChunkLength(i));
+            }
+
+            rhs.Clear();
+        }
+
+        // Chunk lookup is a binary search over the start offsets, which stay few because chunks are large
+        int& operator[](const std::size_t index)
+        {
+            const std::size_t chunk = FindChunk(index);
+            return chunks[chunk][static_cast<unsigned int>(index - chunkStarts[chunk])];
+        }
+
+        const int& operator[](const std::size_t index) const
+        {
+            const std::size_t chunk = FindChunk(index);
+            return chunks[chunk][static_cast<unsigned int>(index - chunkStarts[chunk])];
+        }
+
+        ConstIterator begin() const { return ConstIterator(this, 0); }
+        ConstIterator end() const { return ConstIterator(); }
+
+        // Contiguous copy of the whole rope: one allocation and one bulk copy per chunk
+        MyBuffer<> Flatten() const
+        {
+            MyBuffer<> flat(static_cast<unsigned int>(length));
+            CopyTo(flat.Data());
+            return flat;
+        }
+
+        std::size_t GetLength() const { return length; }
+        std::size_t ChunkCount() const { return chunks.size(); }
+
+        // Lets a rope take part in lazy concatenation: MyBuffer all = rope + buffer;
+        void CopyTo(int* destination) const
+        {
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+            {
+                BufferKernels::Copy(destination, chunks[i].Data(), ChunkLength(i));
+                destination += ChunkLength(i);
+            }
+        }
+
+        void Clear()
+        {
+            chunks.clear();
+            chunkStarts.clear();
+            length = 0;
+            tailUsed = 0;
+        }
+
+    private:
+        std::vector<MyBuffer<>> chunks;
+        std::vector<std::size_t> chunkStarts; // Index of the first element of every chunk
+        std::size_t length = 0;
+        unsigned int tailUsed = 0; // Elements used in the last chunk, the only one that may have free space
+
+        std::size_t ChunkLength(const std::size_t chunk) const
+        {
+            return chunk + 1 < chunks.size() ? chunkStarts[chunk + 1] - chunkStarts[chunk] : tailUsed;
+        }
+
+        std::size_t FindChunk(const std::size_t index) const
+        {
+            return static_cast<std::size_t>(std::upper_bound(chunkStarts.begin(), chunkStarts.end(), index) -
+                                            chunkStarts.begin()) - 1;
+        }
+
+        void AddChunk(MyBuffer<>&& chunk, const unsigned int used)
+        {
+            chunkStarts.push_back(length);
+            chunks.push_back(std::move(chunk));
+            tailUsed = used;
+            length += used;
+        }
+    };
+}
+
+#endif
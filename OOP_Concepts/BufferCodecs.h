@@ -0,0 +1,628 @@
+//
+// Integer compression codecs for MyBuffer<int> payloads
+//
+
+#ifndef BUFFER_CODECS_H_
+#define BUFFER_CODECS_H_
+
+#include "BufferClass.h"
+#include "BufferKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+// Integer codecs for MyBuffer<int> payloads. Encode produces a MyBuffer<std::uint8_t>, so an encoded buffer is saved,
+// mapped and sliced like any other buffer. The values are cut into blocks of kBlockLength that decode independently:
+//   Header (8 bytes) | one 32-bit offset per block | blocks
+// which gives random access to any element by decoding only its block.
+namespace BufferCodecs
+{
+    enum class Codec : std::uint8_t
+    {
+        Delta = 1, // Zig-zag varint of the difference with the previous value: sorted ids, timestamps
+        ZigZagVarint, // Zig-zag varint of the value itself: small values of either sign
+        FrameOfReference, // Block minimum, then every value minus it in the fewest bits that hold the block's range
+        BitPacked // Differences packed in four 32-bit lanes and decoded four at a time with SSE
+    };
+
+    inline constexpr unsigned int kBlockLength = 128;
+    inline constexpr std::uint8_t kVersion = 1;
+
+    struct Header
+    {
+        Codec codec = Codec::Delta;
+        std::uint8_t version = kVersion;
+        std::uint16_t blockLength = kBlockLength;
+        std::uint32_t length = 0; // Values encoded
+    };
+
+    static_assert(sizeof(Header) == 8 && std::is_trivially_copyable_v<Header>);
+
+    // Maps small negative and positive numbers to small unsigned ones: 0, -1, 1, -2, 2 -> 0, 1, 2, 3, 4
+    constexpr std::uint32_t ZigZag(const std::int32_t value)
+    {
+        return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+    }
+
+    constexpr std::int32_t UnZigZag(const std::uint32_t value)
+    {
+        return static_cast<std::int32_t>((value >> 1) ^ (0u - (value & 1u)));
+    }
+
+    // Differences wrap around like unsigned numbers, so INT_MIN after INT_MAX still round-trips
+    constexpr std::int32_t Difference(const std::int32_t value, const std::int32_t previous)
+    {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(value) - static_cast<std::uint32_t>(previous));
+    }
+
+    constexpr std::int32_t Accumulate(const std::int32_t previous, const std::uint32_t difference)
+    {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(previous) + difference);
+    }
+
+    namespace Detail
+    {
+        // Largest encoded block: 128 five-byte varints, or a 5 byte block header and 128 full 32-bit values
+        inline constexpr std::size_t kMaxBlockBytes = kBlockLength * 5 + 8;
+
+        inline std::uint8_t* PutVarint(std::uint8_t* out, std::uint32_t value)
+        {
+            while (value >= 0x80)
+            {
+                *out++ = static_cast<std::uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+
+            *out++ = static_cast<std::uint8_t>(value);
+            return out;
+        }
+
+        // nullptr when the varint runs past end or is longer than five bytes
+        inline const std::uint8_t* GetVarint(const std::uint8_t* in, const std::uint8_t* end, std::uint32_t& value)
+        {
+            value = 0;
+            for (unsigned int shift = 0; shift < 35 && in < end; shift += 7)
+            {
+                const std::uint8_t byte = *in++;
+                value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return in;
+                }
+            }
+
+            return nullptr;
+        }
+
+        inline unsigned int BitWidth(const std::uint32_t value) { return static_cast<unsigned int>(std::bit_width(value)); }
+
+        // Frame of reference keeps the values horizontally: value i occupies bits [i * width, (i + 1) * width)
+        inline std::uint32_t ExtractBits(const std::uint8_t* packed, const std::size_t packedBytes,
+                                         const std::size_t index, const unsigned int width)
+        {
+            if (width == 0)
+            {
+                return 0;
+            }
+
+            const std::size_t bit = index * width;
+            const std::size_t byte = bit / 8;
+            std::uint64_t window = 0;
+            std::memcpy(&window, packed + byte, std::min<std::size_t>(8, packedBytes - byte));
+            window >>= bit % 8;
+            return static_cast<std::uint32_t>(window & ((std::uint64_t{1} << width) - 1));
+        }
+
+        // Bit packing keeps the values vertically: value k sits in lane k % 4 of the k / 4th group, each lane being a
+        // 32-bit word stream of its own. Four consecutive values therefore come out of one 128-bit register.
+        inline void PackLanes(const std::uint32_t* values, const unsigned int width, std::uint8_t* out)
+        {
+            std::array<std::uint32_t, 4 * 32> words{}; // width * 4 of them are used
+            for (unsigned int lane = 0; lane < 4; ++lane)
+            {
+                std::uint64_t accumulator = 0;
+                unsigned int bits = 0;
+                unsigned int word = 0;
+
+                for (unsigned int k = 0; k < kBlockLength / 4; ++k)
+                {
+                    accumulator |= static_cast<std::uint64_t>(values[4 * k + lane]) << bits;
+                    bits += width;
+                    if (bits >= 32)
+                    {
+                        words[4 * word++ + lane] = static_cast<std::uint32_t>(accumulator);
+                        accumulator >>= 32;
+                        bits -= 32;
+                    }
+                }
+            }
+
+            std::memcpy(out, words.data(), width * 16);
+        }
+
+        inline void UnpackLanesScalar(const std::uint8_t* in, const unsigned int width, std::uint32_t* values)
+        {
+            const std::uint64_t mask = (std::uint64_t{1} << width) - 1;
+            for (unsigned int lane = 0; lane < 4; ++lane)
+            {
+                std::uint64_t accumulator = 0;
+                unsigned int bits = 0;
+                unsigned int word = 0;
+
+                for (unsigned int k = 0; k < kBlockLength / 4; ++k)
+                {
+                    if (bits < width)
+                    {
+                        std::uint32_t next = 0;
+                        std::memcpy(&next, in + 4 * (4 * word++ + lane), 4);
+                        accumulator |= static_cast<std::uint64_t>(next) << bits;
+                        bits += 32;
+                    }
+
+                    values[4 * k + lane] = static_cast<std::uint32_t>(accumulator & mask);
+                    accumulator >>= width;
+                    bits -= width;
+                }
+            }
+        }
+
+        // Zig-zag decoding and the running sum of the differences, one value at a time
+        inline void IntegrateScalar(const std::uint32_t* differences, std::int32_t previous, const unsigned int count,
+                                    int* destination)
+        {
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                previous = Accumulate(previous, static_cast<std::uint32_t>(UnZigZag(differences[i])));
+                destination[i] = previous;
+            }
+        }
+
+#ifdef BUFFER_KERNELS_X86
+        // The same unpacking for all four lanes at once: one 128-bit load feeds four values
+        __attribute__((target("sse2"))) inline void UnpackLanesSSE(const std::uint8_t* in, const unsigned int width,
+                                                                   std::uint32_t* values)
+        {
+            const __m128i mask = _mm_set1_epi32(static_cast<int>(static_cast<std::uint32_t>((std::uint64_t{1} << width) - 1)));
+            const auto* words = reinterpret_cast<const __m128i*>(in);
+            __m128i current = _mm_loadu_si128(words);
+            unsigned int word = 0;
+            unsigned int shift = 0;
+
+            for (unsigned int k = 0; k < kBlockLength / 4; ++k)
+            {
+                __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(static_cast<int>(shift)));
+                shift += width;
+                if (shift >= 32)
+                {
+                    shift -= 32;
+                    if (++word < width)
+                    {
+                        current = _mm_loadu_si128(words + word);
+                        if (shift > 0) // The value continues in the next word
+                        {
+                            value = _mm_or_si128(value, _mm_sll_epi32(current,
+                                                                      _mm_cvtsi32_si128(static_cast<int>(width - shift))));
+                        }
+                    }
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 4 * k), _mm_and_si128(value, mask));
+            }
+        }
+
+        // Zig-zag decoding plus a prefix sum inside the register: add the register shifted by one lane, then by two
+        __attribute__((target("sse2"))) inline void IntegrateSSE(const std::uint32_t* differences, std::int32_t previous,
+                                                                 const unsigned int count, int* destination)
+        {
+            const __m128i one = _mm_set1_epi32(1);
+            __m128i running = _mm_set1_epi32(previous);
+            unsigned int i = 0;
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(differences + i));
+                value = _mm_xor_si128(_mm_srli_epi32(value, 1), _mm_sub_epi32(_mm_setzero_si128(),
+                                                                              _mm_and_si128(value, one)));
+                value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+                value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+                value = _mm_add_epi32(value, running);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), value);
+                running = _mm_shuffle_epi32(value, 0xFF);
+            }
+
+            IntegrateScalar(differences + i, _mm_cvtsi128_si32(running), count - i, destination + i);
+        }
+#endif
+
+        inline bool UseSSE()
+        {
+#ifdef BUFFER_KERNELS_X86
+            return BufferKernels::ActiveTable()->level != BufferKernels::KernelLevel::Scalar;
+#else
+            return false;
+#endif
+        }
+
+        // Encodes count (at most kBlockLength) values into out, returns the bytes written
+        inline std::size_t EncodeBlock(const Codec codec, const int* values, const unsigned int count,
+                                       std::uint8_t* out)
+        {
+            std::uint8_t* const start = out;
+
+            switch (codec)
+            {
+                case Codec::Delta:
+                {
+                    std::int32_t previous = 0;
+                    for (unsigned int i = 0; i < count; ++i)
+                    {
+                        out = PutVarint(out, ZigZag(Difference(values[i], previous)));
+                        previous = values[i];
+                    }
+                    break;
+                }
+                case Codec::ZigZagVarint:
+                {
+                    for (unsigned int i = 0; i < count; ++i)
+                    {
+                        out = PutVarint(out, ZigZag(values[i]));
+                    }
+                    break;
+                }
+                case Codec::FrameOfReference:
+                {
+                    const auto [minimum, maximum] = std::minmax_element(values, values + count);
+                    const std::int32_t base = *minimum;
+                    const unsigned int width = BitWidth(static_cast<std::uint32_t>(Difference(*maximum, base)));
+
+                    std::memcpy(out, &base, 4);
+                    out[4] = static_cast<std::uint8_t>(width);
+                    out += 5;
+
+                    std::uint64_t accumulator = 0;
+                    unsigned int bits = 0;
+                    for (unsigned int i = 0; i < count; ++i)
+                    {
+                        accumulator |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(Difference(values[i], base)))
+                            << bits;
+                        bits += width;
+                        while (bits >= 8)
+                        {
+                            *out++ = static_cast<std::uint8_t>(accumulator);
+                            accumulator >>= 8;
+                            bits -= 8;
+                        }
+                    }
+                    if (bits > 0)
+                    {
+                        *out++ = static_cast<std::uint8_t>(accumulator);
+                    }
+                    break;
+                }
+                case Codec::BitPacked:
+                {
+                    // A partial last block is padded with zero differences, the lanes always hold kBlockLength values
+                    std::array<std::uint32_t, kBlockLength> differences{};
+                    std::uint32_t combined = 0;
+                    for (unsigned int i = 1; i < count; ++i)
+                    {
+                        differences[i] = ZigZag(Difference(values[i], values[i - 1]));
+                        combined |= differences[i];
+                    }
+
+                    const std::int32_t first = count > 0 ? values[0] : 0;
+                    const unsigned int width = BitWidth(combined);
+                    std::memcpy(out, &first, 4);
+                    out[4] = static_cast<std::uint8_t>(width);
+                    out += 5;
+
+                    PackLanes(differences.data(), width, out);
+                    out += width * 16;
+                    break;
+                }
+            }
+
+            return static_cast<std::size_t>(out - start);
+        }
+    }
+
+    // Read-only access to an encoded stream: validates the header and the block table once, then decodes single
+    // blocks or single values on demand. It copies nothing, so the bytes may live in a mapped file.
+    class EncodedView
+    {
+    public:
+        explicit EncodedView(const std::span<const std::uint8_t> bytes) : mBytes(bytes)
+        {
+            if (bytes.size() < sizeof(Header))
+            {
+                return;
+            }
+
+            std::memcpy(&mHeader, bytes.data(), sizeof(Header));
+            if (mHeader.version != kVersion || mHeader.blockLength != kBlockLength ||
+                mHeader.codec < Codec::Delta || mHeader.codec > Codec::BitPacked)
+            {
+                return;
+            }
+
+            const std::size_t blocks = GetBlockCount();
+            if (blocks > (bytes.size() - sizeof(Header)) / 4)
+            {
+                return;
+            }
+
+            mBlocks = bytes.data() + sizeof(Header) + blocks * 4;
+            const std::size_t blockBytes = bytes.size() - sizeof(Header) - blocks * 4;
+            std::uint32_t previous = 0;
+
+            for (std::size_t block = 0; block < blocks; ++block)
+            {
+                const std::uint32_t offset = BlockOffset(block);
+                if (offset < previous || offset > blockBytes)
+                {
+                    return;
+                }
+                previous = offset;
+            }
+
+            mValid = true;
+        }
+
+        bool IsValid() const { return mValid; }
+        Codec GetCodec() const { return mHeader.codec; }
+        unsigned int GetLength() const { return mValid ? mHeader.length : 0; }
+        std::size_t GetEncodedBytes() const { return mBytes.size(); }
+
+        std::size_t GetBlockCount() const { return (std::size_t{mHeader.length} + kBlockLength - 1) / kBlockLength; }
+
+        unsigned int BlockLength(const std::size_t block) const
+        {
+            return static_cast<unsigned int>(std::min<std::size_t>(kBlockLength,
+                                                                  mHeader.length - block * kBlockLength));
+        }
+
+        // Writes the BlockLength(block) values of one block. False when the block is damaged.
+        bool DecodeBlock(const std::size_t block, int* destination) const
+        {
+            if (!mValid || block >= GetBlockCount())
+            {
+                return false;
+            }
+
+            const unsigned int count = BlockLength(block);
+            const std::uint8_t* in = mBlocks + BlockOffset(block);
+            const std::uint8_t* end = mBlocks + BlockEnd(block);
+
+            switch (mHeader.codec)
+            {
+                case Codec::Delta:
+                case Codec::ZigZagVarint:
+                {
+                    std::int32_t previous = 0;
+                    for (unsigned int i = 0; i < count; ++i)
+                    {
+                        std::uint32_t value = 0;
+                        in = Detail::GetVarint(in, end, value);
+                        if (in == nullptr)
+                        {
+                            return false;
+                        }
+
+                        previous = mHeader.codec == Codec::Delta ? Accumulate(previous, static_cast<std::uint32_t>(
+                                                                                  UnZigZag(value)))
+                                                                 : UnZigZag(value);
+                        destination[i] = previous;
+                    }
+                    return true;
+                }
+                case Codec::FrameOfReference:
+                {
+                    std::int32_t base = 0;
+                    unsigned int width = 0;
+                    if (!ReadBlockHeader(in, end, base, width) ||
+                        static_cast<std::size_t>(end - in) < (std::size_t{count} * width + 7) / 8)
+                    {
+                        return false;
+                    }
+
+                    const auto packedBytes = static_cast<std::size_t>(end - in);
+                    for (unsigned int i = 0; i < count; ++i)
+                    {
+                        destination[i] = Accumulate(base, Detail::ExtractBits(in, packedBytes, i, width));
+                    }
+                    return true;
+                }
+                case Codec::BitPacked:
+                {
+                    std::int32_t first = 0;
+                    unsigned int width = 0;
+                    if (!ReadBlockHeader(in, end, first, width) || static_cast<std::size_t>(end - in) < width * 16)
+                    {
+                        return false;
+                    }
+
+                    std::array<std::uint32_t, kBlockLength> differences{};
+                    const bool sse = Detail::UseSSE();
+                    if (width > 0)
+                    {
+#ifdef BUFFER_KERNELS_X86
+                        sse ? Detail::UnpackLanesSSE(in, width, differences.data())
+                            : Detail::UnpackLanesScalar(in, width, differences.data());
+#else
+                        Detail::UnpackLanesScalar(in, width, differences.data());
+#endif
+                    }
+
+                    // The first difference is always zero, accumulating from the first value reproduces it
+#ifdef BUFFER_KERNELS_X86
+                    sse ? Detail::IntegrateSSE(differences.data(), first, count, destination)
+                        : Detail::IntegrateScalar(differences.data(), first, count, destination);
+#else
+                    (void)sse;
+                    Detail::IntegrateScalar(differences.data(), first, count, destination);
+#endif
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Random access: decodes only the block that holds index (frame of reference reads just the value itself)
+        std::optional<int> At(const unsigned int index) const
+        {
+            if (index >= GetLength())
+            {
+                return std::nullopt;
+            }
+
+            const std::size_t block = index / kBlockLength;
+            if (mHeader.codec == Codec::FrameOfReference)
+            {
+                const std::uint8_t* in = mBlocks + BlockOffset(block);
+                const std::uint8_t* end = mBlocks + BlockEnd(block);
+                std::int32_t base = 0;
+                unsigned int width = 0;
+                const std::size_t position = index % kBlockLength;
+                if (!ReadBlockHeader(in, end, base, width) ||
+                    static_cast<std::size_t>(end - in) < ((position + 1) * width + 7) / 8)
+                {
+                    return std::nullopt;
+                }
+
+                return Accumulate(base, Detail::ExtractBits(in, static_cast<std::size_t>(end - in), position, width));
+            }
+
+            std::array<int, kBlockLength> values{};
+            if (!DecodeBlock(block, values.data()))
+            {
+                return std::nullopt;
+            }
+
+            return values[index % kBlockLength];
+        }
+
+        // Decodes everything into destination, which holds GetLength() values
+        bool DecodeTo(int* destination) const
+        {
+            for (std::size_t block = 0; block < GetBlockCount(); ++block)
+            {
+                if (!DecodeBlock(block, destination + block * kBlockLength))
+                {
+                    return false;
+                }
+            }
+
+            return mValid;
+        }
+
+    private:
+        std::span<const std::uint8_t> mBytes;
+        Header mHeader{};
+        const std::uint8_t* mBlocks = nullptr;
+        bool mValid = false;
+
+        std::uint32_t BlockOffset(const std::size_t block) const
+        {
+            std::uint32_t offset = 0;
+            std::memcpy(&offset, mBytes.data() + sizeof(Header) + block * 4, 4);
+            return offset;
+        }
+
+        std::size_t BlockEnd(const std::size_t block) const
+        {
+            return block + 1 < GetBlockCount() ? BlockOffset(block + 1)
+                                               : static_cast<std::size_t>(mBytes.data() + mBytes.size() - mBlocks);
+        }
+
+        // Base value and bit width that open a frame of reference or bit-packed block
+        static bool ReadBlockHeader(const std::uint8_t*& in, const std::uint8_t* end, std::int32_t& base,
+                                    unsigned int& width)
+        {
+            if (end - in < 5 || in[4] > 32)
+            {
+                return false;
+            }
+
+            std::memcpy(&base, in, 4);
+            width = in[4];
+            in += 5;
+            return true;
+        }
+    };
+
+    // Encodes the values block by block into a byte buffer sized to fit. Empty when the encoded stream would not fit
+    // in a MyBuffer (more than 4 GiB).
+    inline BufferClass::MyBuffer<std::uint8_t> Encode(const std::span<const int> values, const Codec codec)
+    {
+        const std::size_t blocks = (values.size() + kBlockLength - 1) / kBlockLength;
+        const std::size_t tableEnd = sizeof(Header) + blocks * 4;
+        if (values.size() > std::numeric_limits<std::uint32_t>::max() ||
+            tableEnd > std::numeric_limits<unsigned int>::max())
+        {
+            return BufferClass::MyBuffer<std::uint8_t>(0);
+        }
+
+        BufferClass::MyBuffer<std::uint8_t> encoded(static_cast<unsigned int>(tableEnd));
+        const Header header{codec, kVersion, kBlockLength, static_cast<std::uint32_t>(values.size())};
+        std::memcpy(encoded.Data(), &header, sizeof(header));
+
+        std::array<std::uint8_t, Detail::kMaxBlockBytes> scratch{};
+        std::size_t used = tableEnd;
+
+        for (std::size_t block = 0; block < blocks; ++block)
+        {
+            const std::size_t first = block * kBlockLength;
+            const auto count = static_cast<unsigned int>(std::min<std::size_t>(kBlockLength, values.size() - first));
+            const std::size_t bytes = Detail::EncodeBlock(codec, values.data() + first, count, scratch.data());
+
+            if (used + bytes > std::numeric_limits<unsigned int>::max())
+            {
+                return BufferClass::MyBuffer<std::uint8_t>(0);
+            }
+
+            const auto offset = static_cast<std::uint32_t>(used - tableEnd);
+            encoded.Resize(static_cast<unsigned int>(used + bytes)); // Geometric growth, amortized O(1) per byte
+            std::memcpy(encoded.Data() + sizeof(Header) + block * 4, &offset, 4);
+            std::memcpy(encoded.Data() + used, scratch.data(), bytes);
+            used += bytes;
+        }
+
+        encoded.ShrinkToFit();
+        return encoded;
+    }
+
+    template<typename Allocator>
+    BufferClass::MyBuffer<std::uint8_t> Encode(const BufferClass::MyBuffer<int, Allocator>& buffer, const Codec codec)
+    {
+        return Encode(buffer.Span(), codec);
+    }
+
+    // std::nullopt when the bytes are not a valid encoded stream
+    inline std::optional<BufferClass::MyBuffer<int>> Decode(const std::span<const std::uint8_t> bytes)
+    {
+        const EncodedView view(bytes);
+        if (!view.IsValid())
+        {
+            return std::nullopt;
+        }
+
+        BufferClass::MyBuffer<int> decoded(view.GetLength());
+        if (!view.DecodeTo(decoded.Data()))
+        {
+            return std::nullopt;
+        }
+
+        return decoded;
+    }
+}
+
+#endif
@@ -0,0 +1,474 @@
+//
+// Binary files of MyBuffer records, loaded by mapping them into memory
+//
+
+#ifndef BUFFER_FILE_H_
+#define BUFFER_FILE_H_
+
+#include "BufferClass.h"
+#include "BufferHash.h"
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary files of MyBuffer records:
+//   record = Header (32 bytes) + raw little-endian payload, every record starting on a 64 byte boundary
+//   file   = record record ... index footer (one IndexEntry per record, then a Footer in the last 32 bytes)
+// Loading a record maps its payload straight into a MyBuffer: no parsing and no copy, pages load on first access.
+namespace BufferFile
+{
+    inline constexpr std::array<char, 4> kRecordMagic{'M', 'Y', 'B', 'F'};
+    inline constexpr std::array<char, 4> kIndexMagic{'M', 'Y', 'B', 'I'};
+    // Version 1 checksummed with FNV-1a, version 2 with CRC-32C. Files of both versions can be read.
+    inline constexpr std::uint16_t kVersion = 2;
+    inline constexpr std::uint16_t kOldestVersion = 1;
+    inline constexpr std::size_t kRecordAlignment = 64;
+
+    enum class ElementType : std::uint8_t
+    {
+        Unknown, Int8, UInt8, Int16, UInt16, Int32, UInt32, Int64, UInt64, Float32, Float64
+    };
+
+    // Integers and IEEE floating point: types whose bytes mean the same thing in every process on the same platform
+    template<typename T>
+    concept Serializable = (std::is_integral_v<T> && !std::same_as<T, bool>) ||
+        (std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 && sizeof(T) <= 8);
+
+    template<Serializable T>
+    constexpr ElementType ElementTypeOf()
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return sizeof(T) == 4 ? ElementType::Float32 : ElementType::Float64;
+        }
+        else
+        {
+            constexpr int sizeIndex = std::bit_width(sizeof(T)) - 1; // 1, 2, 4, 8 bytes -> 0, 1, 2, 3
+            return static_cast<ElementType>(1 + 2 * sizeIndex + (std::is_signed_v<T> ? 0 : 1));
+        }
+    }
+
+    struct Header
+    {
+        std::array<char, 4> magic = kRecordMagic;
+        std::uint16_t version = kVersion;
+        ElementType elementType = ElementType::Unknown;
+        std::uint8_t elementSize = 0;
+        std::uint64_t length = 0; // Elements in the payload
+        std::uint64_t checksum = 0; // Of the payload bytes
+        std::uint64_t reserved = 0;
+
+        // A MyBuffer holds at most UINT_MAX elements, so a longer record could never be loaded and is treated as damaged
+        bool IsValid() const
+        {
+            return magic == kRecordMagic && version >= kOldestVersion && version <= kVersion &&
+                elementType != ElementType::Unknown && elementSize != 0 &&
+                length <= std::numeric_limits<unsigned int>::max();
+        }
+
+        std::uint64_t PayloadBytes() const { return length * elementSize; }
+    };
+
+    struct IndexEntry
+    {
+        std::uint64_t offset = 0; // Of the record header from the start of the file
+        std::uint64_t length = 0;
+        std::uint64_t checksum = 0;
+        ElementType elementType = ElementType::Unknown;
+        std::uint8_t elementSize = 0;
+        std::uint16_t version = 0; // Of the record, it decides how the checksum was computed
+        std::array<std::uint8_t, 4> reserved{};
+    };
+
+    struct Footer
+    {
+        std::uint64_t indexOffset = 0;
+        std::uint64_t entryCount = 0;
+        std::uint64_t indexChecksum = 0;
+        std::array<char, 4> magic = kIndexMagic;
+        std::uint16_t version = kVersion;
+        std::uint16_t reserved = 0;
+    };
+
+    // The structures are written as they are in memory, so their layout is part of the format
+    static_assert(sizeof(Header) == 32 && sizeof(IndexEntry) == 32 && sizeof(Footer) == 32);
+    static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<IndexEntry> &&
+                  std::is_trivially_copyable_v<Footer>);
+
+    // The payload is stored little-endian and mapped as it is, so big-endian hosts cannot read or write it
+#ifdef MYBUFFER_HAS_MMAP
+    inline constexpr bool kSupported = std::endian::native == std::endian::little;
+#else
+    inline constexpr bool kSupported = false;
+#endif
+
+    // Catches truncated and corrupted payloads, not deliberate tampering. Version 2 uses CRC-32C, which the crc32
+    // instruction computes at several GB/s; version 1 files carry a 64-bit FNV-1a, one byte at a time.
+    inline std::uint64_t Checksum(const void* data, const std::size_t bytes, const std::uint16_t version = kVersion)
+    {
+        if (version >= 2)
+        {
+            return BufferHash::Crc32c(data, bytes);
+        }
+
+        const auto* byte = static_cast<const unsigned char*>(data);
+        std::uint64_t hash = 14695981039346656037ull;
+
+        for (std::size_t i = 0; i < bytes; ++i)
+        {
+            hash = (hash ^ byte[i]) * 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    constexpr std::uint64_t AlignRecord(const std::uint64_t offset)
+    {
+        return (offset + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+    }
+
+    // Streams buffers into one file. Each Append is a single writev of padding, header and payload straight from the
+    // buffer's memory; Finish (or the destructor) appends the index footer that gives the reader random access.
+    class Writer
+    {
+    public:
+        explicit Writer(const char* path)
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            if constexpr (kSupported)
+            {
+                mFileDescriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            }
+#else
+            (void)path;
+#endif
+        }
+
+        ~Writer() { Finish(); }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool IsOpen() const { return mFileDescriptor >= 0; }
+
+        // Records written so far
+        std::size_t GetCount() const { return mIndex.size(); }
+
+        template<Serializable T>
+        bool Append(const std::span<const T> elements)
+        {
+            if (!IsOpen())
+            {
+                return false;
+            }
+
+            Header header;
+            header.elementType = ElementTypeOf<T>();
+            header.elementSize = sizeof(T);
+            header.length = elements.size();
+            header.checksum = Checksum(elements.data(), elements.size_bytes());
+
+            static constexpr std::array<char, kRecordAlignment> padding{};
+            const std::uint64_t recordOffset = AlignRecord(mOffset);
+            const std::size_t paddingBytes = recordOffset - mOffset;
+
+            const std::array<Piece, 3> pieces{Piece{padding.data(), paddingBytes}, Piece{&header, sizeof(header)},
+                                              Piece{elements.data(), elements.size_bytes()}};
+            if (!WritePieces(pieces))
+            {
+                return false;
+            }
+
+            mIndex.push_back(IndexEntry{recordOffset, header.length, header.checksum, header.elementType,
+                                        header.elementSize, header.version});
+            return true;
+        }
+
+        template<typename T, typename Allocator>
+        bool Append(const BufferClass::MyBuffer<T, Allocator>& buffer)
+        {
+            return Append(buffer.Span());
+        }
+
+        template<typename T>
+        bool Append(const BufferClass::BufferView<T>& view)
+        {
+            return Append(std::span<const std::remove_const_t<T>>(view.Data(), view.GetLength()));
+        }
+
+        // Writes the index footer and closes the file. False if any write failed along the way.
+        bool Finish()
+        {
+            if (!IsOpen())
+            {
+                return !mFailed && mFinished;
+            }
+
+            Footer footer;
+            footer.indexOffset = mOffset;
+            footer.entryCount = mIndex.size();
+            footer.indexChecksum = Checksum(mIndex.data(), mIndex.size() * sizeof(IndexEntry));
+
+            const std::array<Piece, 2> pieces{Piece{mIndex.data(), mIndex.size() * sizeof(IndexEntry)},
+                                              Piece{&footer, sizeof(footer)}};
+            WritePieces(pieces);
+
+#ifdef MYBUFFER_HAS_MMAP
+            if (close(mFileDescriptor) != 0)
+            {
+                mFailed = true;
+            }
+#endif
+            mFileDescriptor = -1;
+            mFinished = true;
+            return !mFailed;
+        }
+
+    private:
+        struct Piece
+        {
+            const void* data;
+            std::size_t bytes;
+        };
+
+        int mFileDescriptor = -1;
+        std::uint64_t mOffset = 0;
+        std::vector<IndexEntry> mIndex;
+        bool mFailed = false;
+        bool mFinished = false;
+
+        // One writev for all the pieces; a short write only resumes where the kernel stopped
+        template<std::size_t count>
+        bool WritePieces(const std::array<Piece, count>& pieces)
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            std::array<iovec, count> vectors{};
+            std::size_t remaining = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                vectors[i] = iovec{const_cast<void*>(pieces[i].data), pieces[i].bytes};
+                remaining += pieces[i].bytes;
+            }
+
+            iovec* next = vectors.data();
+            int left = static_cast<int>(count);
+            while (remaining > 0)
+            {
+                const ssize_t written = writev(mFileDescriptor, next, left);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    mFailed = true;
+                    return false;
+                }
+
+                remaining -= static_cast<std::size_t>(written);
+                mOffset += static_cast<std::uint64_t>(written);
+
+                auto advance = static_cast<std::size_t>(written);
+                while (left > 0 && advance >= next->iov_len)
+                {
+                    advance -= next->iov_len;
+                    ++next;
+                    --left;
+                }
+                if (left > 0)
+                {
+                    next->iov_base = static_cast<char*>(next->iov_base) + advance;
+                    next->iov_len -= advance;
+                }
+            }
+
+            return true;
+#else
+            (void)pieces;
+            mFailed = true;
+            return false;
+#endif
+        }
+    };
+
+    // Finds the records of a file: from the index footer, or by walking the headers when the file has no footer
+    // (a writer that never reached Finish). Load maps one record into a MyBuffer.
+    class Reader
+    {
+    public:
+        explicit Reader(const char* path) : mPath(path)
+        {
+#ifdef MYBUFFER_HAS_MMAP
+            if constexpr (kSupported)
+            {
+                const int fileDescriptor = open(path, O_RDONLY);
+                if (fileDescriptor < 0)
+                {
+                    return;
+                }
+
+                struct stat fileInfo{};
+                if (fstat(fileDescriptor, &fileInfo) == 0)
+                {
+                    const auto fileSize = static_cast<std::uint64_t>(fileInfo.st_size);
+                    mOpen = ReadIndex(fileDescriptor, fileSize) || WalkRecords(fileDescriptor, fileSize);
+                }
+
+                close(fileDescriptor);
+            }
+#endif
+        }
+
+        bool IsOpen() const { return mOpen; }
+
+        std::size_t GetCount() const { return mIndex.size(); }
+
+        const IndexEntry& Entry(const std::size_t index) const { return mIndex[index]; }
+
+        // Maps record index as a MyBuffer<T>. std::nullopt when the record does not exist, holds another element
+        // type, or its payload fails the checksum. verifyChecksum reads every page once; skip it to keep the load
+        // lazy when the file is trusted.
+        template<Serializable T>
+        std::optional<BufferClass::MyBuffer<T>> Load(const std::size_t index,
+                                                     const BufferClass::MapMode mode = BufferClass::MapMode::ReadOnly,
+                                                     const bool verifyChecksum = true) const
+        {
+            if (index >= mIndex.size() || mIndex[index].elementType != ElementTypeOf<T>() ||
+                mIndex[index].elementSize != sizeof(T))
+            {
+                return std::nullopt;
+            }
+
+            const IndexEntry& entry = mIndex[index];
+            if (entry.length == 0)
+            {
+                return BufferClass::MyBuffer<T>(0);
+            }
+
+            BufferClass::MyBuffer<T> buffer(BufferClass::mappedFile, mPath.c_str(), mode, entry.offset + sizeof(Header),
+                                            entry.length);
+            if (!buffer.IsMapped() || (verifyChecksum && Checksum(buffer.Data(), entry.length * sizeof(T),
+                                                                  entry.version) != entry.checksum))
+            {
+                return std::nullopt;
+            }
+
+            return buffer;
+        }
+
+    private:
+        std::string mPath;
+        std::vector<IndexEntry> mIndex;
+        bool mOpen = false;
+
+#ifdef MYBUFFER_HAS_MMAP
+        static bool ReadExactly(const int fileDescriptor, void* destination, const std::size_t bytes,
+                                const std::uint64_t offset)
+        {
+            std::size_t done = 0;
+            while (done < bytes)
+            {
+                const ssize_t read = pread(fileDescriptor, static_cast<char*>(destination) + done, bytes - done,
+                                           static_cast<off_t>(offset + done));
+                if (read < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (read <= 0)
+                {
+                    return false;
+                }
+
+                done += static_cast<std::size_t>(read);
+            }
+
+            return true;
+        }
+
+        bool ReadIndex(const int fileDescriptor, const std::uint64_t fileSize)
+        {
+            Footer footer;
+            if (fileSize < sizeof(Footer) ||
+                !ReadExactly(fileDescriptor, &footer, sizeof(footer), fileSize - sizeof(Footer)) ||
+                footer.magic != kIndexMagic || footer.version < kOldestVersion || footer.version > kVersion ||
+                footer.entryCount > (fileSize - sizeof(Footer)) / sizeof(IndexEntry) ||
+                footer.indexOffset + footer.entryCount * sizeof(IndexEntry) + sizeof(Footer) != fileSize)
+            {
+                return false;
+            }
+
+            mIndex.resize(footer.entryCount);
+            const std::size_t indexBytes = mIndex.size() * sizeof(IndexEntry);
+            if (!ReadExactly(fileDescriptor, mIndex.data(), indexBytes, footer.indexOffset) ||
+                Checksum(mIndex.data(), indexBytes, footer.version) != footer.indexChecksum)
+            {
+                mIndex.clear();
+                return false;
+            }
+
+            for (IndexEntry& entry : mIndex)
+            {
+                Header header;
+                if (!ReadExactly(fileDescriptor, &header, sizeof(header), entry.offset) || !header.IsValid() ||
+                    header.elementType != entry.elementType || header.length != entry.length ||
+                    entry.offset + sizeof(Header) + header.PayloadBytes() > footer.indexOffset)
+                {
+                    mIndex.clear();
+                    return false;
+                }
+
+                entry.version = header.version; // Version 1 indexes did not record it
+            }
+
+            return true;
+        }
+
+        // Keeps every complete record up to the first damaged or truncated one
+        bool WalkRecords(const int fileDescriptor, const std::uint64_t fileSize)
+        {
+            std::uint64_t offset = 0;
+            Header header;
+
+            while (offset + sizeof(Header) <= fileSize &&
+                   ReadExactly(fileDescriptor, &header, sizeof(header), offset) && header.IsValid() &&
+                   header.PayloadBytes() <= fileSize - offset - sizeof(Header))
+            {
+                mIndex.push_back(IndexEntry{offset, header.length, header.checksum, header.elementType,
+                                            header.elementSize, header.version});
+                offset = AlignRecord(offset + sizeof(Header) + header.PayloadBytes());
+            }
+
+            return !mIndex.empty();
+        }
+#endif
+    };
+
+    // One buffer per file
+    template<typename T, typename Allocator>
+    bool Save(const BufferClass::MyBuffer<T, Allocator>& buffer, const char* path)
+    {
+        Writer writer(path);
+        return writer.Append(buffer) && writer.Finish();
+    }
+
+    template<Serializable T>
+    std::optional<BufferClass::MyBuffer<T>> Load(const char* path,
+                                                 const BufferClass::MapMode mode = BufferClass::MapMode::ReadOnly,
+                                                 const bool verifyChecksum = true)
+    {
+        return Reader(path).Load<T>(0, mode, verifyChecksum);
+    }
+}
+
+#endif
@@ -0,0 +1,385 @@
+//
+// CRC-32C and 64-bit hashes of buffer contents
+//
+
+#ifndef BUFFER_HASH_H_
+#define BUFFER_HASH_H_
+
+#include "BufferKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace BufferHash
+{
+    // CRC-32C (Castagnoli), the CRC that SSE4.2 computes in hardware and that iSCSI, ext4 and many storage formats use.
+    // The scalar fallback is slicing-by-8: eight 256-entry tables let one iteration fold in eight bytes with eight
+    // independent lookups instead of eight dependent ones.
+    inline constexpr std::uint32_t kCrc32cPolynomial = 0x82F63B78; // Reflected form of 0x1EDC6F41
+
+    using Crc32cTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+    // std::byteswap arrives with C++23; compilers turn this loop into a single bswap instruction
+    template<std::unsigned_integral T>
+    constexpr T ByteSwap(T value)
+    {
+        T swapped = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i)
+        {
+            swapped = static_cast<T>((swapped << 8) | (value & 0xFF));
+            value = static_cast<T>(value >> 8);
+        }
+
+        return swapped;
+    }
+
+    constexpr Crc32cTables MakeCrc32cTables()
+    {
+        Crc32cTables tables{};
+        for (std::uint32_t byte = 0; byte < 256; ++byte)
+        {
+            std::uint32_t crc = byte;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ ((crc & 1u) != 0 ? kCrc32cPolynomial : 0u);
+            }
+            tables[0][byte] = crc;
+        }
+
+        for (std::size_t slice = 1; slice < tables.size(); ++slice)
+        {
+            for (std::size_t byte = 0; byte < 256; ++byte)
+            {
+                const std::uint32_t previous = tables[slice - 1][byte];
+                tables[slice][byte] = (previous >> 8) ^ tables[0][previous & 0xFF];
+            }
+        }
+
+        return tables;
+    }
+
+    inline constexpr Crc32cTables kCrc32cTables = MakeCrc32cTables();
+
+    // Both update functions continue from crc, the state before the final inversion (start with 0xFFFFFFFF)
+    inline std::uint32_t UpdateCrc32cSlicing(std::uint32_t crc, const std::byte* data, std::size_t bytes)
+    {
+        const auto& table = kCrc32cTables;
+        for (; bytes >= 8; bytes -= 8, data += 8)
+        {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data, 8);
+            if constexpr (std::endian::native == std::endian::big)
+            {
+                word = ByteSwap(word);
+            }
+            word ^= crc;
+
+            crc = table[7][word & 0xFF] ^ table[6][(word >> 8) & 0xFF] ^ table[5][(word >> 16) & 0xFF] ^
+                table[4][(word >> 24) & 0xFF] ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF] ^
+                table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+        }
+
+        for (; bytes > 0; --bytes, ++data)
+        {
+            crc = (crc >> 8) ^ table[0][(crc ^ static_cast<std::uint32_t>(*data)) & 0xFF];
+        }
+
+        return crc;
+    }
+
+    // a * b modulo the CRC polynomial, in the reflected bit order the CRC state uses (bit 31 is x^0)
+    constexpr std::uint32_t MultiplyModPolynomial(const std::uint32_t a, std::uint32_t b)
+    {
+        std::uint32_t product = 0;
+        for (std::uint32_t bit = 1u << 31; bit != 0; bit >>= 1)
+        {
+            if ((a & bit) != 0)
+            {
+                product ^= b;
+            }
+            b = (b & 1u) != 0 ? (b >> 1) ^ kCrc32cPolynomial : b >> 1;
+        }
+
+        return product;
+    }
+
+    // x^exponent modulo the polynomial: running the CRC over n zero bytes multiplies the state by x^(8n)
+    constexpr std::uint32_t PowerOfXModPolynomial(std::uint64_t exponent)
+    {
+        std::uint32_t result = 1u << 31; // 1
+        std::uint32_t square = 1u << 30; // x
+        for (; exponent != 0; exponent >>= 1)
+        {
+            if ((exponent & 1) != 0)
+            {
+                result = MultiplyModPolynomial(result, square);
+            }
+            square = MultiplyModPolynomial(square, square);
+        }
+
+        return result;
+    }
+
+#if defined(BUFFER_KERNELS_X86) && defined(__x86_64__)
+#define BUFFER_HASH_HAS_CRC32_INSTRUCTION 1
+
+    // One crc32 instruction folds in eight bytes, but each one waits 3 cycles for the previous result. Three
+    // independent streams over consecutive blocks keep the unit busy every cycle; the partial CRCs are then joined:
+    // crc(A B C) = crc(A) * x^(8 * 2 * block) + crc(B) * x^(8 * block) + crc(C)
+    __attribute__((target("sse4.2"))) inline std::uint32_t UpdateCrc32cSSE42(std::uint32_t crc, const std::byte* data,
+                                                                            std::size_t bytes)
+    {
+        constexpr std::size_t kBlockBytes = 4096;
+        constexpr std::uint32_t kShiftOneBlock = PowerOfXModPolynomial(8 * kBlockBytes);
+        constexpr std::uint32_t kShiftTwoBlocks = PowerOfXModPolynomial(8 * 2 * kBlockBytes);
+
+        auto load = [](const std::byte* address)
+        {
+            std::uint64_t word = 0;
+            std::memcpy(&word, address, 8);
+            return word;
+        };
+
+        std::uint64_t wide = crc;
+        for (; bytes >= 3 * kBlockBytes; bytes -= 3 * kBlockBytes, data += 3 * kBlockBytes)
+        {
+            std::uint64_t first = wide;
+            std::uint64_t second = 0;
+            std::uint64_t third = 0;
+            for (std::size_t i = 0; i < kBlockBytes; i += 8)
+            {
+                first = _mm_crc32_u64(first, load(data + i));
+                second = _mm_crc32_u64(second, load(data + kBlockBytes + i));
+                third = _mm_crc32_u64(third, load(data + 2 * kBlockBytes + i));
+            }
+
+            wide = MultiplyModPolynomial(kShiftTwoBlocks, static_cast<std::uint32_t>(first)) ^
+                MultiplyModPolynomial(kShiftOneBlock, static_cast<std::uint32_t>(second)) ^
+                static_cast<std::uint32_t>(third);
+        }
+
+        for (; bytes >= 8; bytes -= 8, data += 8)
+        {
+            wide = _mm_crc32_u64(wide, load(data));
+        }
+
+        crc = static_cast<std::uint32_t>(wide);
+        for (; bytes > 0; --bytes, ++data)
+        {
+            crc = _mm_crc32_u8(crc, static_cast<unsigned char>(*data));
+        }
+
+        return crc;
+    }
+#endif
+
+    inline bool HasCrc32Instruction()
+    {
+#ifdef BUFFER_HASH_HAS_CRC32_INSTRUCTION
+        static const bool supported = __builtin_cpu_supports("sse4.2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    inline std::uint32_t UpdateCrc32c(const std::uint32_t crc, const std::byte* data, const std::size_t bytes)
+    {
+#ifdef BUFFER_HASH_HAS_CRC32_INSTRUCTION
+        if (HasCrc32Instruction())
+        {
+            return UpdateCrc32cSSE42(crc, data, bytes);
+        }
+#endif
+        return UpdateCrc32cSlicing(crc, data, bytes);
+    }
+
+    inline std::uint32_t Crc32c(const void* data, const std::size_t bytes)
+    {
+        return ~UpdateCrc32c(0xFFFFFFFFu, static_cast<const std::byte*>(data), bytes);
+    }
+
+    // Feed it pieces in order (slices of a buffer, chunks as they arrive over the network) and Finish gives the same
+    // value as Crc32c over everything at once
+    class Crc32cHasher
+    {
+    public:
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        Crc32cHasher& Update(const std::span<const T> elements)
+        {
+            return UpdateBytes(elements.data(), elements.size_bytes());
+        }
+
+        Crc32cHasher& UpdateBytes(const void* data, const std::size_t bytes)
+        {
+            mState = UpdateCrc32c(mState, static_cast<const std::byte*>(data), bytes);
+            return *this;
+        }
+
+        std::uint32_t Finish() const { return ~mState; }
+
+    private:
+        std::uint32_t mState = 0xFFFFFFFFu;
+    };
+
+    // XXH64 (Yann Collet's xxHash, 64-bit variant): four independent multiply-rotate lanes over 32-byte stripes, so
+    // the CPU overlaps their multiplications. Fast, well distributed, not cryptographic. Same value on every platform.
+    namespace Detail
+    {
+        inline constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+        inline constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+        inline constexpr std::uint64_t kPrime3 = 0x165667B19E3779F9ull;
+        inline constexpr std::uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+        inline constexpr std::uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+        inline std::uint64_t Read64(const std::byte* data)
+        {
+            std::uint64_t value = 0;
+            std::memcpy(&value, data, 8);
+            return std::endian::native == std::endian::little ? value : ByteSwap(value);
+        }
+
+        inline std::uint32_t Read32(const std::byte* data)
+        {
+            std::uint32_t value = 0;
+            std::memcpy(&value, data, 4);
+            return std::endian::native == std::endian::little ? value : ByteSwap(value);
+        }
+
+        constexpr std::uint64_t Round(const std::uint64_t accumulator, const std::uint64_t input)
+        {
+            return std::rotl(accumulator + input * kPrime2, 31) * kPrime1;
+        }
+
+        constexpr std::uint64_t MergeRound(const std::uint64_t hash, const std::uint64_t accumulator)
+        {
+            return (hash ^ Round(0, accumulator)) * kPrime1 + kPrime4;
+        }
+    }
+
+    class Hasher64
+    {
+    public:
+        explicit Hasher64(const std::uint64_t seed = 0)
+            : mSeed(seed), mLanes{seed + Detail::kPrime1 + Detail::kPrime2, seed + Detail::kPrime2, seed,
+                                  seed - Detail::kPrime1}
+        {
+        }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        Hasher64& Update(const std::span<const T> elements)
+        {
+            return UpdateBytes(elements.data(), elements.size_bytes());
+        }
+
+        Hasher64& UpdateBytes(const void* data, std::size_t bytes)
+        {
+            const auto* input = static_cast<const std::byte*>(data);
+            mTotalBytes += bytes;
+
+            if (mPendingBytes > 0) // Complete the stripe a previous Update left unfinished
+            {
+                const std::size_t taken = std::min(bytes, kStripeBytes - mPendingBytes);
+                std::memcpy(mPending.data() + mPendingBytes, input, taken);
+                mPendingBytes += taken;
+                input += taken;
+                bytes -= taken;
+
+                if (mPendingBytes < kStripeBytes)
+                {
+                    return *this;
+                }
+
+                ConsumeStripe(mPending.data());
+                mPendingBytes = 0;
+            }
+
+            for (; bytes >= kStripeBytes; bytes -= kStripeBytes, input += kStripeBytes)
+            {
+                ConsumeStripe(input);
+            }
+
+            std::memcpy(mPending.data(), input, bytes);
+            mPendingBytes = bytes;
+            return *this;
+        }
+
+        std::uint64_t Finish() const
+        {
+            using namespace Detail;
+
+            std::uint64_t hash = 0;
+            if (mTotalBytes >= kStripeBytes)
+            {
+                hash = std::rotl(mLanes[0], 1) + std::rotl(mLanes[1], 7) + std::rotl(mLanes[2], 12) +
+                    std::rotl(mLanes[3], 18);
+                for (const std::uint64_t lane : mLanes)
+                {
+                    hash = MergeRound(hash, lane);
+                }
+            }
+            else
+            {
+                hash = mSeed + kPrime5;
+            }
+            hash += mTotalBytes;
+
+            const std::byte* tail = mPending.data();
+            std::size_t bytes = mPendingBytes;
+            for (; bytes >= 8; bytes -= 8, tail += 8)
+            {
+                hash = std::rotl(hash ^ Round(0, Read64(tail)), 27) * kPrime1 + kPrime4;
+            }
+            if (bytes >= 4)
+            {
+                hash = std::rotl(hash ^ (static_cast<std::uint64_t>(Read32(tail)) * kPrime1), 23) * kPrime2 + kPrime3;
+                bytes -= 4;
+                tail += 4;
+            }
+            for (; bytes > 0; --bytes, ++tail)
+            {
+                hash = std::rotl(hash ^ (static_cast<std::uint64_t>(*tail) * kPrime5), 11) * kPrime1;
+            }
+
+            // Avalanche: every input bit affects every output bit
+            hash ^= hash >> 33;
+            hash *= kPrime2;
+            hash ^= hash >> 29;
+            hash *= kPrime3;
+            hash ^= hash >> 32;
+            return hash;
+        }
+
+    private:
+        static constexpr std::size_t kStripeBytes = 32;
+
+        std::uint64_t mSeed;
+        std::array<std::uint64_t, 4> mLanes;
+        std::array<std::byte, kStripeBytes> mPending{};
+        std::size_t mPendingBytes = 0;
+        std::uint64_t mTotalBytes = 0;
+
+        void ConsumeStripe(const std::byte* stripe)
+        {
+            for (std::size_t lane = 0; lane < mLanes.size(); ++lane)
+            {
+                mLanes[lane] = Detail::Round(mLanes[lane], Detail::Read64(stripe + 8 * lane));
+            }
+        }
+    };
+
+    inline std::uint64_t Hash64(const void* data, const std::size_t bytes, const std::uint64_t seed = 0)
+    {
+        return Hasher64(seed).UpdateBytes(data, bytes).Finish();
+    }
+}
+
+#endif
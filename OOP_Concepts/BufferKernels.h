@@ -0,0 +1,956 @@
+//
+// Scalar, SSE and AVX2 versions of the bulk int operations behind MyBuffer, picked once at runtime
+//
+
+#ifndef BUFFER_KERNELS_H_
+#define BUFFER_KERNELS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BUFFER_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace BufferKernels
+{
+    // Internal bulk operations used by MyBuffer. Each operation exists as a scalar reference, an SSE version and an
+    // AVX2 version; the widest one the CPU supports is picked once at startup.
+    enum class KernelLevel { Scalar, SSE, AVX2 };
+
+    // Asks for the cache line holding address ahead of the load that needs it. A hint only: compilers without the
+    // builtin get nothing, and the searches that use it still work.
+    inline void Prefetch([[maybe_unused]] const void* address)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // The tests FindIf and CountIf evaluate a whole register of elements at a time: x == low, x < low, x > low and
+    // low <= x <= high. Any element type can use them through operator(), int goes through the kernels.
+    enum class PredicateKind { Equal, Less, Greater, Between };
+
+    template<typename T = int>
+    struct Predicate
+    {
+        PredicateKind kind = PredicateKind::Equal;
+        T low{};
+        T high{}; // Only used by Between
+
+        static constexpr Predicate Equal(const T& value) { return Predicate{PredicateKind::Equal, value, value}; }
+        static constexpr Predicate Less(const T& value) { return Predicate{PredicateKind::Less, value, value}; }
+        static constexpr Predicate Greater(const T& value) { return Predicate{PredicateKind::Greater, value, value}; }
+        static constexpr Predicate Between(const T& low, const T& high)
+        {
+            return Predicate{PredicateKind::Between, low, high};
+        }
+
+        constexpr bool operator()(const T& value) const
+        {
+            switch (kind)
+            {
+                case PredicateKind::Equal:
+                    return value == low;
+                case PredicateKind::Less:
+                    return value < low;
+                case PredicateKind::Greater:
+                    return low < value;
+                case PredicateKind::Between:
+                    return !(value < low) && !(high < value);
+            }
+            return false;
+        }
+    };
+
+    // Calls function.template operator()<kind>(), so the kernels compile one loop per kind and test nothing per element
+    template<typename Function>
+    decltype(auto) WithKind(const PredicateKind kind, Function&& function)
+    {
+        switch (kind)
+        {
+            case PredicateKind::Less:
+                return function.template operator()<PredicateKind::Less>();
+            case PredicateKind::Greater:
+                return function.template operator()<PredicateKind::Greater>();
+            case PredicateKind::Between:
+                return function.template operator()<PredicateKind::Between>();
+            case PredicateKind::Equal:
+                break;
+        }
+        return function.template operator()<PredicateKind::Equal>();
+    }
+
+    struct KernelTable
+    {
+        KernelLevel level;
+        const char* name;
+        void (*copy)(int* destination, const int* source, std::size_t count);
+        void (*fill)(int* destination, int value, std::size_t count);
+        bool (*equal)(const int* lhs, const int* rhs, std::size_t count);
+        int (*compare)(const int* lhs, const int* rhs, std::size_t count); // <0, 0, >0 on the first difference
+        long long (*sum)(const int* source, std::size_t count);
+        void (*minMax)(const int* source, std::size_t count, int& minimum, int& maximum);
+        std::size_t (*count)(const int* source, std::size_t count, int value);
+        std::size_t (*findIf)(const int* source, std::size_t count, Predicate<int> predicate); // count if none
+        std::size_t (*countIf)(const int* source, std::size_t count, Predicate<int> predicate);
+        // Bit i of bits[i / 64] set when source[i] passes, returns how many do. Unused bits of the last word are zero.
+        std::size_t (*selectIf)(const int* source, std::size_t count, Predicate<int> predicate, std::uint64_t* bits);
+    };
+
+    namespace Scalar
+    {
+        inline void Copy(int* destination, const int* source, const std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination[i] = source[i];
+            }
+        }
+
+        inline void Fill(int* destination, const int value, const std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination[i] = value;
+            }
+        }
+
+        inline bool Equal(const int* lhs, const int* rhs, const std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (lhs[i] != rhs[i])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        inline int Compare(const int* lhs, const int* rhs, const std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (lhs[i] != rhs[i])
+                {
+                    return lhs[i] < rhs[i] ? -1 : 1;
+                }
+            }
+
+            return 0;
+        }
+
+        inline long long Sum(const int* source, const std::size_t count)
+        {
+            long long total = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                total += source[i];
+            }
+
+            return total;
+        }
+
+        // An empty range leaves minimum at INT_MAX and maximum at INT_MIN, the identities of min and max
+        inline void MinMax(const int* source, const std::size_t count, int& minimum, int& maximum)
+        {
+            minimum = std::numeric_limits<int>::max();
+            maximum = std::numeric_limits<int>::min();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                minimum = source[i] < minimum ? source[i] : minimum;
+                maximum = source[i] > maximum ? source[i] : maximum;
+            }
+        }
+
+        inline std::size_t Count(const int* source, const std::size_t count, const int value)
+        {
+            std::size_t matches = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                matches += source[i] == value;
+            }
+
+            return matches;
+        }
+
+        template<PredicateKind kind>
+        inline bool Matches(const int value, const int low, const int high)
+        {
+            if constexpr (kind == PredicateKind::Equal)
+            {
+                return value == low;
+            }
+            else if constexpr (kind == PredicateKind::Less)
+            {
+                return value < low;
+            }
+            else if constexpr (kind == PredicateKind::Greater)
+            {
+                return value > low;
+            }
+            else
+            {
+                return (value >= low) & (value <= high);
+            }
+        }
+
+        // Eight results are gathered into a bit mask without branching, then one branch tests all eight
+        template<PredicateKind kind>
+        std::size_t FindIfKind(const int* source, const std::size_t count, const int low, const int high)
+        {
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                unsigned int mask = 0;
+                for (unsigned int lane = 0; lane < 8; ++lane)
+                {
+                    mask |= static_cast<unsigned int>(Matches<kind>(source[i + lane], low, high)) << lane;
+                }
+
+                if (mask != 0)
+                {
+                    return i + static_cast<std::size_t>(std::countr_zero(mask));
+                }
+            }
+
+            for (; i < count; ++i)
+            {
+                if (Matches<kind>(source[i], low, high))
+                {
+                    return i;
+                }
+            }
+
+            return count;
+        }
+
+        template<PredicateKind kind>
+        std::size_t CountIfKind(const int* source, const std::size_t count, const int low, const int high)
+        {
+            std::size_t matches = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                matches += Matches<kind>(source[i], low, high);
+            }
+
+            return matches;
+        }
+
+        inline std::size_t FindIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return FindIfKind<kind>(source, count, predicate.low, predicate.high);
+            });
+        }
+
+        inline std::size_t CountIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return CountIfKind<kind>(source, count, predicate.low, predicate.high);
+            });
+        }
+
+        template<PredicateKind kind>
+        std::size_t SelectIfKind(const int* source, const std::size_t count, const int low, const int high,
+                                 std::uint64_t* bits)
+        {
+            std::size_t selected = 0;
+            for (std::size_t first = 0; first < count; first += 64)
+            {
+                const std::size_t length = std::min<std::size_t>(64, count - first);
+                std::uint64_t word = 0;
+                for (std::size_t i = 0; i < length; ++i)
+                {
+                    word |= static_cast<std::uint64_t>(Matches<kind>(source[first + i], low, high)) << i;
+                }
+
+                bits[first / 64] = word;
+                selected += static_cast<std::size_t>(std::popcount(word));
+            }
+
+            return selected;
+        }
+
+        inline std::size_t SelectIf(const int* source, const std::size_t count, const Predicate<int> predicate,
+                                    std::uint64_t* bits)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return SelectIfKind<kind>(source, count, predicate.low, predicate.high, bits);
+            });
+        }
+    }
+
+#ifdef BUFFER_KERNELS_X86
+    namespace SSE
+    {
+        __attribute__((target("sse2"))) inline void Copy(int* destination, const int* source, const std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+            }
+
+            Scalar::Copy(destination + i, source + i, count - i);
+        }
+
+        __attribute__((target("sse2"))) inline void Fill(int* destination, const int value, const std::size_t count)
+        {
+            const __m128i broadcast = _mm_set1_epi32(value);
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), broadcast);
+            }
+
+            Scalar::Fill(destination + i, value, count - i);
+        }
+
+        __attribute__((target("sse2"))) inline bool Equal(const int* lhs, const int* rhs, const std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xFFFF)
+                {
+                    return false;
+                }
+            }
+
+            return Scalar::Equal(lhs + i, rhs + i, count - i);
+        }
+
+        __attribute__((target("sse2"))) inline int Compare(const int* lhs, const int* rhs, const std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+                const unsigned int equalMask = _mm_movemask_epi8(_mm_cmpeq_epi32(a, b));
+                if (equalMask != 0xFFFF)
+                {
+                    // Each int owns 4 bits of the byte mask, the lowest clear bit marks the first difference
+                    const std::size_t first = i + __builtin_ctz(~equalMask) / 4;
+                    return lhs[first] < rhs[first] ? -1 : 1;
+                }
+            }
+
+            return Scalar::Compare(lhs + i, rhs + i, count - i);
+        }
+
+        __attribute__((target("sse2"))) inline long long Sum(const int* source, const std::size_t count)
+        {
+            __m128i total = _mm_setzero_si128(); // Two 64-bit lanes, so the sum cannot overflow an int
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                const __m128i signs = _mm_srai_epi32(values, 31); // Sign extension without SSE4.1
+                total = _mm_add_epi64(total, _mm_unpacklo_epi32(values, signs));
+                total = _mm_add_epi64(total, _mm_unpackhi_epi32(values, signs));
+            }
+
+            alignas(16) long long lanes[2];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+            return lanes[0] + lanes[1] + Scalar::Sum(source + i, count - i);
+        }
+
+        __attribute__((target("sse2"))) inline void MinMax(const int* source, const std::size_t count, int& minimum,
+                                                           int& maximum)
+        {
+            Scalar::MinMax(nullptr, 0, minimum, maximum);
+            std::size_t i = 0;
+
+            if (count >= 4)
+            {
+                // SSE2 has no 32-bit min/max, so select with a comparison mask instead
+                __m128i lowest = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+                __m128i highest = lowest;
+                for (i = 4; i + 4 <= count; i += 4)
+                {
+                    const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                    const __m128i lower = _mm_cmpgt_epi32(lowest, values);
+                    const __m128i higher = _mm_cmpgt_epi32(values, highest);
+                    lowest = _mm_or_si128(_mm_and_si128(lower, values), _mm_andnot_si128(lower, lowest));
+                    highest = _mm_or_si128(_mm_and_si128(higher, values), _mm_andnot_si128(higher, highest));
+                }
+
+                alignas(16) int lanes[8];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), lowest);
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), highest);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    minimum = std::min(minimum, lanes[lane]);
+                    maximum = std::max(maximum, lanes[lane + 4]);
+                }
+            }
+
+            int tailMinimum, tailMaximum;
+            Scalar::MinMax(source + i, count - i, tailMinimum, tailMaximum);
+            minimum = std::min(minimum, tailMinimum);
+            maximum = std::max(maximum, tailMaximum);
+        }
+
+        __attribute__((target("sse2"))) inline std::size_t Count(const int* source, const std::size_t count,
+                                                                 const int value)
+        {
+            const __m128i broadcast = _mm_set1_epi32(value);
+            __m128i matches = _mm_setzero_si128(); // Each lane counts up by subtracting the -1 of a match
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                matches = _mm_sub_epi32(matches, _mm_cmpeq_epi32(values, broadcast));
+            }
+
+            alignas(16) unsigned int lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), matches);
+            return std::size_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3] + Scalar::Count(source + i, count - i, value);
+        }
+
+        // All ones in the lanes that pass the test
+        template<PredicateKind kind>
+        __attribute__((target("sse2"))) inline __m128i Matches(const __m128i values, const __m128i low,
+                                                               const __m128i high)
+        {
+            if constexpr (kind == PredicateKind::Equal)
+            {
+                return _mm_cmpeq_epi32(values, low);
+            }
+            else if constexpr (kind == PredicateKind::Less)
+            {
+                return _mm_cmplt_epi32(values, low);
+            }
+            else if constexpr (kind == PredicateKind::Greater)
+            {
+                return _mm_cmpgt_epi32(values, low);
+            }
+            else
+            {
+                return _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi32(values, low), _mm_cmpgt_epi32(values, high)),
+                                        _mm_set1_epi32(-1));
+            }
+        }
+
+        __attribute__((target("sse2"))) inline unsigned int LaneMask(const __m128i matches)
+        {
+            return static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+        }
+
+        // 16 elements per iteration: four registers tested, one branch on all of them
+        template<PredicateKind kind>
+        __attribute__((target("sse2"))) std::size_t FindIfKind(const int* source, const std::size_t count,
+                                                               const int low, const int high)
+        {
+            const __m128i lowBroadcast = _mm_set1_epi32(low);
+            const __m128i highBroadcast = _mm_set1_epi32(high);
+            std::size_t i = 0;
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto* block = reinterpret_cast<const __m128i*>(source + i);
+                const __m128i first = Matches<kind>(_mm_loadu_si128(block), lowBroadcast, highBroadcast);
+                const __m128i second = Matches<kind>(_mm_loadu_si128(block + 1), lowBroadcast, highBroadcast);
+                const __m128i third = Matches<kind>(_mm_loadu_si128(block + 2), lowBroadcast, highBroadcast);
+                const __m128i fourth = Matches<kind>(_mm_loadu_si128(block + 3), lowBroadcast, highBroadcast);
+
+                if (LaneMask(_mm_or_si128(_mm_or_si128(first, second), _mm_or_si128(third, fourth))) != 0)
+                {
+                    const unsigned int mask = LaneMask(first) | LaneMask(second) << 4 | LaneMask(third) << 8 |
+                        LaneMask(fourth) << 12;
+                    return i + static_cast<std::size_t>(std::countr_zero(mask));
+                }
+            }
+
+            return i + Scalar::FindIfKind<kind>(source + i, count - i, low, high);
+        }
+
+        template<PredicateKind kind>
+        __attribute__((target("sse2"))) std::size_t CountIfKind(const int* source, const std::size_t count,
+                                                                const int low, const int high)
+        {
+            const __m128i lowBroadcast = _mm_set1_epi32(low);
+            const __m128i highBroadcast = _mm_set1_epi32(high);
+            __m128i matches = _mm_setzero_si128();
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                matches = _mm_sub_epi32(matches, Matches<kind>(values, lowBroadcast, highBroadcast));
+            }
+
+            alignas(16) unsigned int lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), matches);
+            return std::size_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3] +
+                Scalar::CountIfKind<kind>(source + i, count - i, low, high);
+        }
+
+        // One word of bits from 16 registers of 4 elements
+        template<PredicateKind kind>
+        __attribute__((target("sse2"))) std::size_t SelectIfKind(const int* source, const std::size_t count,
+                                                                 const int low, const int high, std::uint64_t* bits)
+        {
+            const __m128i lowBroadcast = _mm_set1_epi32(low);
+            const __m128i highBroadcast = _mm_set1_epi32(high);
+            std::size_t selected = 0;
+            std::size_t i = 0;
+            for (; i + 64 <= count; i += 64)
+            {
+                std::uint64_t word = 0;
+                for (unsigned int group = 0; group < 16; ++group)
+                {
+                    const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4 * group));
+                    word |= static_cast<std::uint64_t>(LaneMask(Matches<kind>(values, lowBroadcast, highBroadcast)))
+                        << (4 * group);
+                }
+
+                bits[i / 64] = word;
+                selected += static_cast<std::size_t>(std::popcount(word));
+            }
+
+            return selected + Scalar::SelectIfKind<kind>(source + i, count - i, low, high, bits + i / 64);
+        }
+
+        inline std::size_t FindIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return FindIfKind<kind>(source, count, predicate.low, predicate.high);
+            });
+        }
+
+        inline std::size_t CountIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return CountIfKind<kind>(source, count, predicate.low, predicate.high);
+            });
+        }
+
+        inline std::size_t SelectIf(const int* source, const std::size_t count, const Predicate<int> predicate,
+                                    std::uint64_t* bits)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return SelectIfKind<kind>(source, count, predicate.low, predicate.high, bits);
+            });
+        }
+    }
+
+    namespace AVX2
+    {
+        __attribute__((target("avx2"))) inline void Copy(int* destination, const int* source, const std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)));
+            }
+
+            SSE::Copy(destination + i, source + i, count - i);
+        }
+
+        __attribute__((target("avx2"))) inline void Fill(int* destination, const int value, const std::size_t count)
+        {
+            const __m256i broadcast = _mm256_set1_epi32(value);
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), broadcast);
+            }
+
+            SSE::Fill(destination + i, value, count - i);
+        }
+
+        __attribute__((target("avx2"))) inline bool Equal(const int* lhs, const int* rhs, const std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+                if (static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b))) != 0xFFFFFFFFu)
+                {
+                    return false;
+                }
+            }
+
+            return SSE::Equal(lhs + i, rhs + i, count - i);
+        }
+
+        __attribute__((target("avx2"))) inline int Compare(const int* lhs, const int* rhs, const std::size_t count)
+        {
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+                const unsigned int equalMask = _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b));
+                if (equalMask != 0xFFFFFFFFu)
+                {
+                    const std::size_t first = i + __builtin_ctz(~equalMask) / 4;
+                    return lhs[first] < rhs[first] ? -1 : 1;
+                }
+            }
+
+            return SSE::Compare(lhs + i, rhs + i, count - i);
+        }
+
+        __attribute__((target("avx2"))) inline long long Sum(const int* source, const std::size_t count)
+        {
+            __m256i total = _mm256_setzero_si256();
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                total = _mm256_add_epi64(total, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+                total = _mm256_add_epi64(total, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+            }
+
+            alignas(32) long long lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SSE::Sum(source + i, count - i);
+        }
+
+        __attribute__((target("avx2"))) inline void MinMax(const int* source, const std::size_t count, int& minimum,
+                                                           int& maximum)
+        {
+            Scalar::MinMax(nullptr, 0, minimum, maximum);
+            std::size_t i = 0;
+
+            if (count >= 8)
+            {
+                __m256i lowest = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+                __m256i highest = lowest;
+                for (i = 8; i + 8 <= count; i += 8)
+                {
+                    const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                    lowest = _mm256_min_epi32(lowest, values);
+                    highest = _mm256_max_epi32(highest, values);
+                }
+
+                alignas(32) int lanes[16];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), lowest);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 8), highest);
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    minimum = std::min(minimum, lanes[lane]);
+                    maximum = std::max(maximum, lanes[lane + 8]);
+                }
+            }
+
+            int tailMinimum, tailMaximum;
+            SSE::MinMax(source + i, count - i, tailMinimum, tailMaximum);
+            minimum = std::min(minimum, tailMinimum);
+            maximum = std::max(maximum, tailMaximum);
+        }
+
+        __attribute__((target("avx2"))) inline std::size_t Count(const int* source, const std::size_t count,
+                                                                 const int value)
+        {
+            const __m256i broadcast = _mm256_set1_epi32(value);
+            __m256i matches = _mm256_setzero_si256();
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                matches = _mm256_sub_epi32(matches, _mm256_cmpeq_epi32(values, broadcast));
+            }
+
+            alignas(32) unsigned int lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), matches);
+            std::size_t total = SSE::Count(source + i, count - i, value);
+            for (const unsigned int lane : lanes)
+            {
+                total += lane;
+            }
+
+            return total;
+        }
+
+        template<PredicateKind kind>
+        __attribute__((target("avx2"))) inline __m256i Matches(const __m256i values, const __m256i low,
+                                                               const __m256i high)
+        {
+            if constexpr (kind == PredicateKind::Equal)
+            {
+                return _mm256_cmpeq_epi32(values, low);
+            }
+            else if constexpr (kind == PredicateKind::Less)
+            {
+                return _mm256_cmpgt_epi32(low, values);
+            }
+            else if constexpr (kind == PredicateKind::Greater)
+            {
+                return _mm256_cmpgt_epi32(values, low);
+            }
+            else
+            {
+                return _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(low, values),
+                                                           _mm256_cmpgt_epi32(values, high)), _mm256_set1_epi32(-1));
+            }
+        }
+
+        __attribute__((target("avx2"))) inline unsigned int LaneMask(const __m256i matches)
+        {
+            return static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(matches)));
+        }
+
+        // 32 elements per iteration, the SSE version finishes the tail
+        template<PredicateKind kind>
+        __attribute__((target("avx2"))) std::size_t FindIfKind(const int* source, const std::size_t count,
+                                                               const int low, const int high)
+        {
+            const __m256i lowBroadcast = _mm256_set1_epi32(low);
+            const __m256i highBroadcast = _mm256_set1_epi32(high);
+            std::size_t i = 0;
+            for (; i + 32 <= count; i += 32)
+            {
+                const auto* block = reinterpret_cast<const __m256i*>(source + i);
+                const __m256i first = Matches<kind>(_mm256_loadu_si256(block), lowBroadcast, highBroadcast);
+                const __m256i second = Matches<kind>(_mm256_loadu_si256(block + 1), lowBroadcast, highBroadcast);
+                const __m256i third = Matches<kind>(_mm256_loadu_si256(block + 2), lowBroadcast, highBroadcast);
+                const __m256i fourth = Matches<kind>(_mm256_loadu_si256(block + 3), lowBroadcast, highBroadcast);
+
+                if (!_mm256_testz_si256(_mm256_or_si256(first, second), _mm256_or_si256(first, second)) ||
+                    !_mm256_testz_si256(_mm256_or_si256(third, fourth), _mm256_or_si256(third, fourth)))
+                {
+                    const unsigned int mask = LaneMask(first) | LaneMask(second) << 8 | LaneMask(third) << 16 |
+                        LaneMask(fourth) << 24;
+                    return i + static_cast<std::size_t>(std::countr_zero(mask));
+                }
+            }
+
+            return i + SSE::FindIfKind<kind>(source + i, count - i, low, high);
+        }
+
+        template<PredicateKind kind>
+        __attribute__((target("avx2"))) std::size_t CountIfKind(const int* source, const std::size_t count,
+                                                                const int low, const int high)
+        {
+            const __m256i lowBroadcast = _mm256_set1_epi32(low);
+            const __m256i highBroadcast = _mm256_set1_epi32(high);
+            __m256i matches = _mm256_setzero_si256();
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                matches = _mm256_sub_epi32(matches, Matches<kind>(values, lowBroadcast, highBroadcast));
+            }
+
+            alignas(32) unsigned int lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), matches);
+            std::size_t total = SSE::CountIfKind<kind>(source + i, count - i, low, high);
+            for (const unsigned int lane : lanes)
+            {
+                total += lane;
+            }
+
+            return total;
+        }
+
+        // One word of bits from 8 registers of 8 elements
+        template<PredicateKind kind>
+        __attribute__((target("avx2"))) std::size_t SelectIfKind(const int* source, const std::size_t count,
+                                                                 const int low, const int high, std::uint64_t* bits)
+        {
+            const __m256i lowBroadcast = _mm256_set1_epi32(low);
+            const __m256i highBroadcast = _mm256_set1_epi32(high);
+            std::size_t selected = 0;
+            std::size_t i = 0;
+            for (; i + 64 <= count; i += 64)
+            {
+                std::uint64_t word = 0;
+                for (unsigned int group = 0; group < 8; ++group)
+                {
+                    const __m256i values = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(source + i + 8 * group));
+                    word |= static_cast<std::uint64_t>(LaneMask(Matches<kind>(values, lowBroadcast, highBroadcast)))
+                        << (8 * group);
+                }
+
+                bits[i / 64] = word;
+                selected += static_cast<std::size_t>(std::popcount(word));
+            }
+
+            return selected + Scalar::SelectIfKind<kind>(source + i, count - i, low, high, bits + i / 64);
+        }
+
+        inline std::size_t FindIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return FindIfKind<kind>(source, count, predicate.low, predicate.high);
+            });
+        }
+
+        inline std::size_t CountIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return CountIfKind<kind>(source, count, predicate.low, predicate.high);
+            });
+        }
+
+        inline std::size_t SelectIf(const int* source, const std::size_t count, const Predicate<int> predicate,
+                                    std::uint64_t* bits)
+        {
+            return WithKind(predicate.kind, [&]<PredicateKind kind>()
+            {
+                return SelectIfKind<kind>(source, count, predicate.low, predicate.high, bits);
+            });
+        }
+    }
+#endif
+
+    inline bool IsSupported(const KernelLevel level)
+    {
+#ifdef BUFFER_KERNELS_X86
+        switch (level)
+        {
+            case KernelLevel::AVX2:
+                return __builtin_cpu_supports("avx2");
+            case KernelLevel::SSE:
+                return __builtin_cpu_supports("sse2");
+            case KernelLevel::Scalar:
+                return true;
+        }
+        return false;
+#else
+        return level == KernelLevel::Scalar;
+#endif
+    }
+
+    inline const KernelTable& TableFor(const KernelLevel level)
+    {
+        static constexpr KernelTable scalarTable{KernelLevel::Scalar, "Scalar", Scalar::Copy, Scalar::Fill,
+                                                 Scalar::Equal, Scalar::Compare, Scalar::Sum, Scalar::MinMax,
+                                                 Scalar::Count, Scalar::FindIf, Scalar::CountIf, Scalar::SelectIf};
+#ifdef BUFFER_KERNELS_X86
+        static constexpr KernelTable sseTable{KernelLevel::SSE, "SSE", SSE::Copy, SSE::Fill, SSE::Equal, SSE::Compare,
+                                              SSE::Sum, SSE::MinMax, SSE::Count, SSE::FindIf, SSE::CountIf,
+                                              SSE::SelectIf};
+        static constexpr KernelTable avx2Table{KernelLevel::AVX2, "AVX2", AVX2::Copy, AVX2::Fill, AVX2::Equal,
+                                               AVX2::Compare, AVX2::Sum, AVX2::MinMax, AVX2::Count, AVX2::FindIf,
+                                               AVX2::CountIf, AVX2::SelectIf};
+        switch (level)
+        {
+            case KernelLevel::AVX2:
+                return avx2Table;
+            case KernelLevel::SSE:
+                return sseTable;
+            case KernelLevel::Scalar:
+                break;
+        }
+#endif
+        (void)level;
+        return scalarTable;
+    }
+
+    inline KernelLevel DetectBestLevel()
+    {
+        if (IsSupported(KernelLevel::AVX2))
+        {
+            return KernelLevel::AVX2;
+        }
+
+        return IsSupported(KernelLevel::SSE) ? KernelLevel::SSE : KernelLevel::Scalar;
+    }
+
+    // Resolved once, on first use. Atomic because SetLevel may switch it while pool workers run kernels; relaxed is
+    // enough, the tables are constants that exist before any thread can load a pointer to them.
+    inline std::atomic<const KernelTable*>& ActiveTableSlot()
+    {
+        static std::atomic<const KernelTable*> active{&TableFor(DetectBestLevel())};
+        return active;
+    }
+
+    // The table every MyBuffer operation goes through
+    inline const KernelTable* ActiveTable()
+    {
+        return ActiveTableSlot().load(std::memory_order_relaxed);
+    }
+
+    // Forces a specific level, mostly to check the wide paths against the scalar one. Returns false and keeps the
+    // current table when the CPU does not support the requested level.
+    inline bool SetLevel(const KernelLevel level)
+    {
+        if (!IsSupported(level))
+        {
+            return false;
+        }
+
+        ActiveTableSlot().store(&TableFor(level), std::memory_order_relaxed);
+        return true;
+    }
+
+    inline void Copy(int* destination, const int* source, const std::size_t count)
+    {
+        ActiveTable()->copy(destination, source, count);
+    }
+
+    inline void Fill(int* destination, const int value, const std::size_t count)
+    {
+        ActiveTable()->fill(destination, value, count);
+    }
+
+    inline bool Equal(const int* lhs, const int* rhs, const std::size_t count)
+    {
+        return ActiveTable()->equal(lhs, rhs, count);
+    }
+
+    inline int Compare(const int* lhs, const int* rhs, const std::size_t count)
+    {
+        return ActiveTable()->compare(lhs, rhs, count);
+    }
+
+    inline long long Sum(const int* source, const std::size_t count)
+    {
+        return ActiveTable()->sum(source, count);
+    }
+
+    inline void MinMax(const int* source, const std::size_t count, int& minimum, int& maximum)
+    {
+        ActiveTable()->minMax(source, count, minimum, maximum);
+    }
+
+    inline std::size_t Count(const int* source, const std::size_t count, const int value)
+    {
+        return ActiveTable()->count(source, count, value);
+    }
+
+    // Index of the first element that passes predicate, count when none does
+    inline std::size_t FindIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+    {
+        return ActiveTable()->findIf(source, count, predicate);
+    }
+
+    inline std::size_t CountIf(const int* source, const std::size_t count, const Predicate<int> predicate)
+    {
+        return ActiveTable()->countIf(source, count, predicate);
+    }
+
+    // Selection bitmap of count elements into (count + 63) / 64 words of bits, returns how many are selected
+    inline std::size_t SelectIf(const int* source, const std::size_t count, const Predicate<int> predicate,
+                                std::uint64_t* bits)
+    {
+        return ActiveTable()->selectIf(source, count, predicate, bits);
+    }
+}
+
+#endif
@@ -0,0 +1,305 @@
+//
+// Fork-join worker pool and the chunked parallel loops used by the MyBuffer algorithms
+//
+
+#ifndef BUFFER_PARALLEL_H_
+#define BUFFER_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef MYBUFFER_USE_STD_EXECUTION
+#include <execution>
+#endif
+
+namespace BufferParallel
+{
+    // Buffers shorter than threshold are processed on the calling thread with the SIMD kernels, longer ones are
+    // split in chunks that run in parallel. threads = 0 means "let the library decide": the C++17 parallel
+    // algorithms when the build enables them (MYBUFFER_USE_STD_EXECUTION), otherwise one worker per hardware thread.
+    // Any other value runs exactly that many threads on the internal pool. An exception thrown by the element function
+    // reaches the caller from the internal pool; the standard parallel algorithms call std::terminate instead.
+    struct Settings
+    {
+        std::size_t threshold = std::size_t{1} << 18;
+        unsigned int threads = 0;
+    };
+
+    inline Settings& Config()
+    {
+        static Settings settings;
+        return settings;
+    }
+
+    // Fork-join pool: Run hands out task indices to the workers and to the calling thread, and returns once every
+    // task has finished. Runs from different threads take turns. A task that calls Run again (a parallel algorithm
+    // inside a parallel algorithm) gets its tasks run inline: waiting for the pool from inside the pool would deadlock.
+    // The first exception a task throws, on any thread, stops the remaining tasks and is rethrown by Run once every
+    // thread has stopped using the task.
+    class WorkerPool
+    {
+    private:
+        static inline thread_local bool runningTask = false;
+
+        // Marks the current thread as running pool tasks, and restores the previous state however it is left
+        class TaskScope
+        {
+        private:
+            bool previous;
+
+        public:
+            TaskScope() : previous(runningTask) { runningTask = true; }
+            ~TaskScope() { runningTask = previous; }
+
+            TaskScope(const TaskScope&) = delete;
+            TaskScope& operator=(const TaskScope&) = delete;
+        };
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::mutex runMutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(std::size_t)>* job = nullptr;
+        std::size_t jobTasks = 0;
+        std::size_t generation = 0;
+        std::size_t activeWorkers = 0;
+        std::atomic<std::size_t> nextTask{0};
+        std::exception_ptr failure; // First exception thrown by a task of the current Run
+        bool stopping = false;
+
+        void Drain(const std::function<void(std::size_t)>& task, const std::size_t taskCount)
+        {
+            const TaskScope scope;
+            try
+            {
+                for (std::size_t index = nextTask.fetch_add(1); index < taskCount; index = nextTask.fetch_add(1))
+                {
+                    task(index);
+                }
+            }
+            catch (...)
+            {
+                nextTask.store(taskCount); // Hand out no more indices, the tasks already running finish
+                std::lock_guard lock(mutex);
+                if (failure == nullptr)
+                {
+                    failure = std::current_exception();
+                }
+            }
+        }
+
+        void WorkerLoop()
+        {
+            std::size_t seenGeneration = 0;
+            std::unique_lock lock(mutex);
+
+            while (true)
+            {
+                wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping)
+                {
+                    return;
+                }
+
+                seenGeneration = generation;
+                if (job == nullptr)
+                {
+                    continue; // Woke up after that Run already finished
+                }
+
+                const std::function<void(std::size_t)>* task = job;
+                const std::size_t taskCount = jobTasks;
+                ++activeWorkers;
+                lock.unlock();
+
+                Drain(*task, taskCount);
+
+                lock.lock();
+                if (--activeWorkers == 0)
+                {
+                    done.notify_all();
+                }
+            }
+        }
+
+    public:
+        explicit WorkerPool(const unsigned int threadCount)
+        {
+            // The calling thread works too, so threadCount - 1 workers
+            for (unsigned int i = 1; i < threadCount; ++i)
+            {
+                workers.emplace_back([this]() { WorkerLoop(); });
+            }
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard lock(mutex);
+                stopping = true;
+            }
+
+            wake.notify_all();
+            for (std::thread& worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        unsigned int ThreadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+        // True on a thread that is running one of the pool's tasks
+        static bool InsideTask() { return runningTask; }
+
+        void Run(const std::size_t taskCount, const std::function<void(std::size_t)>& task)
+        {
+            if (runningTask)
+            {
+                for (std::size_t index = 0; index < taskCount; ++index)
+                {
+                    task(index);
+                }
+                return;
+            }
+
+            std::lock_guard runLock(runMutex);
+            {
+                std::lock_guard lock(mutex);
+                job = &task;
+                jobTasks = taskCount;
+                nextTask.store(0);
+                ++generation;
+            }
+
+            wake.notify_all();
+            Drain(task, taskCount);
+
+            // Every index has been handed out, wait for the workers still running theirs: task must outlive them
+            std::unique_lock lock(mutex);
+            done.wait(lock, [this]() { return activeWorkers == 0; });
+            job = nullptr;
+
+            if (failure != nullptr)
+            {
+                const std::exception_ptr thrown = std::exchange(failure, nullptr);
+                lock.unlock();
+                std::rethrow_exception(thrown);
+            }
+        }
+    };
+
+    inline unsigned int ResolvedThreadCount()
+    {
+        const unsigned int configured = Config().threads;
+        return configured != 0 ? configured : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // The pool is rebuilt when the configured thread count changes. Callers share ownership, so a pool replaced by
+    // another thread lives until the Run still using it returns.
+    inline std::shared_ptr<WorkerPool> Pool()
+    {
+        static std::mutex poolMutex;
+        static std::shared_ptr<WorkerPool> pool;
+        const unsigned int threads = ResolvedThreadCount();
+
+        std::lock_guard lock(poolMutex);
+        if (pool == nullptr || pool->ThreadCount() != threads)
+        {
+            pool = std::make_shared<WorkerPool>(threads);
+        }
+
+        return pool;
+    }
+
+    inline bool IsParallel(const std::size_t count)
+    {
+        return count >= Config().threshold && (Config().threads != 1);
+    }
+
+    // A few chunks per thread, so a slow thread does not hold everybody back
+    inline std::size_t ChunkCount(const std::size_t count)
+    {
+        return std::min<std::size_t>(count, std::size_t{ResolvedThreadCount()} * 4);
+    }
+
+    // Calls chunkFunction(chunk, begin, end) for every chunk of [0, count), in parallel
+    template<typename ChunkFunction>
+    void ForEachChunk(const std::size_t count, ChunkFunction&& chunkFunction)
+    {
+        const std::size_t chunks = ChunkCount(count);
+        auto runChunk = [&](const std::size_t chunk)
+        {
+            chunkFunction(chunk, count * chunk / chunks, count * (chunk + 1) / chunks);
+        };
+
+#ifdef MYBUFFER_USE_STD_EXECUTION
+        if (Config().threads == 0)
+        {
+            std::vector<std::size_t> chunkIndices(chunks);
+            std::iota(chunkIndices.begin(), chunkIndices.end(), std::size_t{0});
+            std::for_each(std::execution::par, chunkIndices.begin(), chunkIndices.end(), runChunk);
+            return;
+        }
+#endif
+        if (WorkerPool::InsideTask())
+        {
+            // Already on one of the pool's threads: the outer call keeps the others busy
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                runChunk(chunk);
+            }
+            return;
+        }
+
+        Pool()->Run(chunks, runChunk);
+    }
+
+    // Sequential below the threshold, otherwise chunkResult(begin, end) per chunk folded together with combine
+    template<typename Result, typename ChunkResult, typename Combine>
+    Result Reduce(const std::size_t count, const Result identity, ChunkResult&& chunkResult, Combine&& combine)
+    {
+        if (!IsParallel(count))
+        {
+            return chunkResult(std::size_t{0}, count);
+        }
+
+        std::vector<Result> partials(ChunkCount(count), identity);
+        ForEachChunk(count, [&](const std::size_t chunk, const std::size_t begin, const std::size_t end)
+        {
+            partials[chunk] = chunkResult(begin, end);
+        });
+
+        return std::accumulate(partials.begin(), partials.end(), identity, combine);
+    }
+
+    template<typename RangeFunction>
+    void ForEachRange(const std::size_t count, RangeFunction&& rangeFunction)
+    {
+        if (!IsParallel(count))
+        {
+            rangeFunction(std::size_t{0}, count);
+            return;
+        }
+
+        ForEachChunk(count, [&](std::size_t, const std::size_t begin, const std::size_t end)
+        {
+            rangeFunction(begin, end);
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,347 @@
+//
+// Sorting networks, radix sort and parallel merge sort for MyBuffer elements
+//
+
+#ifndef BUFFER_SORT_H_
+#define BUFFER_SORT_H_
+
+#include "BufferParallel.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BufferSort
+{
+    // Below kNetworkLimit elements a sorting network, below kRadixLimit std::sort (the radix passes do not pay off
+    // yet), above it LSD radix sort. Buffers past BufferParallel::Config().threshold are sorted in chunks on all
+    // threads and merged.
+    inline constexpr std::size_t kNetworkLimit = 32;
+    inline constexpr std::size_t kRadixLimit = 1024;
+
+    // 32- and 64-bit integers sort by their bytes: 8 bits per pass, at most 4 or 8 passes of counting and scattering
+    template<typename T>
+    concept RadixKey = std::is_integral_v<T> && !std::same_as<T, bool> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+    // The default comparison, the only one the radix path can take over
+    template<typename Compare, typename T>
+    concept DefaultOrder = std::same_as<Compare, std::less<>> || std::same_as<Compare, std::less<T>>;
+
+    // Batcher's merge exchange (Knuth, Algorithm 5.2.2M): the same compare-exchange sequence for any data, so the
+    // loop has no data-dependent branches and each exchange compiles to a min and a max. Not stable.
+    template<typename T, typename Compare>
+    void NetworkSort(T* elements, const std::size_t count, Compare compare)
+    {
+        if (count < 2)
+        {
+            return;
+        }
+
+        for (std::size_t p = std::bit_ceil(count) / 2; p > 0; p /= 2)
+        {
+            std::size_t q = std::bit_ceil(count) / 2;
+            std::size_t r = 0;
+            std::size_t d = p;
+
+            while (true)
+            {
+                for (std::size_t i = 0; i + d < count; ++i)
+                {
+                    if ((i & p) == r)
+                    {
+                        const bool swap = compare(elements[i + d], elements[i]);
+                        T low = swap ? elements[i + d] : elements[i];
+                        T high = swap ? elements[i] : elements[i + d];
+                        elements[i] = std::move(low);
+                        elements[i + d] = std::move(high);
+                    }
+                }
+
+                if (q == p)
+                {
+                    break;
+                }
+
+                d = q - p;
+                q /= 2;
+                r = p;
+            }
+        }
+    }
+
+    template<typename T>
+    using RadixBits = std::make_unsigned_t<T>;
+
+    // Flipping the sign bit makes signed keys compare like their unsigned bytes
+    template<RadixKey T>
+    constexpr RadixBits<T> ToRadix(const T value)
+    {
+        constexpr RadixBits<T> signFlip = std::is_signed_v<T> ? RadixBits<T>{1} << (sizeof(T) * 8 - 1) : 0;
+        return static_cast<RadixBits<T>>(value) ^ signFlip;
+    }
+
+    // Stable LSD radix sort of keys[0, count) using scratch of the same size. Payloads (indices for ArgSort) follow
+    // their keys when non-null. One pass counts every digit; passes where all keys share the digit are skipped,
+    // so small ranges cost fewer passes.
+    template<RadixKey T, typename Payload = unsigned int>
+    void RadixSort(T* keys, T* keysScratch, const std::size_t count, Payload* payload = nullptr,
+                   Payload* payloadScratch = nullptr)
+    {
+        constexpr std::size_t passes = sizeof(T);
+        std::array<std::array<std::size_t, 256>, passes> histograms{};
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const RadixBits<T> bits = ToRadix(keys[i]);
+            for (std::size_t pass = 0; pass < passes; ++pass)
+            {
+                ++histograms[pass][(bits >> (8 * pass)) & 0xFF];
+            }
+        }
+
+        T* source = keys;
+        T* destination = keysScratch;
+        Payload* payloadSource = payload;
+        Payload* payloadDestination = payloadScratch;
+
+        for (std::size_t pass = 0; pass < passes; ++pass)
+        {
+            std::array<std::size_t, 256>& histogram = histograms[pass];
+            if (std::ranges::find(histogram, count) != histogram.end())
+            {
+                continue; // Every key has the same digit here, the pass would not move anything
+            }
+
+            std::size_t offset = 0;
+            for (std::size_t& bucket : histogram)
+            {
+                offset += std::exchange(bucket, offset);
+            }
+
+            const unsigned int shift = static_cast<unsigned int>(8 * pass);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const std::size_t target = histogram[(ToRadix(source[i]) >> shift) & 0xFF]++;
+                destination[target] = source[i];
+                if (payloadSource != nullptr)
+                {
+                    payloadDestination[target] = payloadSource[i];
+                }
+            }
+
+            std::swap(source, destination);
+            std::swap(payloadSource, payloadDestination);
+        }
+
+        if (source != keys)
+        {
+            std::copy_n(source, count, keys);
+            if (payload != nullptr)
+            {
+                std::copy_n(payloadSource, count, payload);
+            }
+        }
+    }
+
+    // Sorts one range on the calling thread with the best algorithm for its size. scratch holds count elements and is
+    // only used by the radix path.
+    template<typename T, typename Compare>
+    void SortRange(T* elements, T* scratch, const std::size_t count, Compare compare, const bool stable)
+    {
+        if constexpr (RadixKey<T> && DefaultOrder<Compare, T>)
+        {
+            if (count >= kRadixLimit)
+            {
+                RadixSort(elements, scratch, count);
+                return;
+            }
+        }
+        else
+        {
+            (void)scratch;
+        }
+
+        if (stable)
+        {
+            std::stable_sort(elements, elements + count, compare);
+        }
+        else if (count < kNetworkLimit)
+        {
+            NetworkSort(elements, count, compare);
+        }
+        else
+        {
+            std::sort(elements, elements + count, compare);
+        }
+    }
+
+    // Number of elements of the stable merge of lhs and rhs that come from lhs among its first outputs elements
+    // (the merge path of Odeh, Green, Mwassi et al.): a binary search, so each thread finds its part of a merge alone
+    template<typename T, typename Compare>
+    std::size_t CoRank(const std::size_t outputs, const T* lhs, const std::size_t lhsCount, const T* rhs,
+                       const std::size_t rhsCount, Compare& compare)
+    {
+        std::size_t low = outputs > rhsCount ? outputs - rhsCount : 0;
+        std::size_t high = std::min(outputs, lhsCount);
+
+        while (low < high)
+        {
+            const std::size_t taken = low + (high - low) / 2;
+            // Too few from lhs while lhs[taken] still goes before rhs[outputs - taken - 1] (ties go to lhs)
+            if (!compare(rhs[outputs - taken - 1], lhs[taken]))
+            {
+                low = taken + 1;
+            }
+            else
+            {
+                high = taken;
+            }
+        }
+
+        return low;
+    }
+
+    // Sorts chunks in parallel, then merges pairs of sorted runs until one is left. Every merge round is split over
+    // the threads by output position, so the last rounds, with only a couple of long runs, stay parallel too.
+    template<typename T, typename Compare>
+    void ParallelSort(T* elements, T* scratch, const std::size_t count, Compare compare, const bool stable)
+    {
+        const std::size_t chunks = BufferParallel::ChunkCount(count);
+        std::vector<std::size_t> runStarts(chunks + 1);
+        for (std::size_t chunk = 0; chunk <= chunks; ++chunk)
+        {
+            runStarts[chunk] = count * chunk / chunks;
+        }
+
+        BufferParallel::ForEachChunk(count, [&](std::size_t, const std::size_t begin, const std::size_t end)
+        {
+            SortRange(elements + begin, scratch + begin, end - begin, compare, stable);
+        });
+
+        T* source = elements;
+        T* destination = scratch;
+        while (runStarts.size() > 2)
+        {
+            BufferParallel::ForEachChunk(count, [&](std::size_t, const std::size_t begin, const std::size_t end)
+            {
+                // Merge pairs (run 2k, run 2k + 1) wherever they overlap this slice of the output
+                for (std::size_t run = 0; run + 1 < runStarts.size(); run += 2)
+                {
+                    const std::size_t pairStart = runStarts[run];
+                    const std::size_t middle = runStarts[run + 1];
+                    const std::size_t pairEnd = run + 2 < runStarts.size() ? runStarts[run + 2] : middle;
+                    if (pairEnd <= begin || pairStart >= end)
+                    {
+                        continue;
+                    }
+
+                    const std::size_t first = std::max(begin, pairStart) - pairStart;
+                    const std::size_t last = std::min(end, pairEnd) - pairStart;
+                    const T* lhs = source + pairStart;
+                    const T* rhs = source + middle;
+                    const std::size_t lhsCount = middle - pairStart;
+                    const std::size_t rhsCount = pairEnd - middle;
+
+                    const std::size_t lhsFirst = CoRank(first, lhs, lhsCount, rhs, rhsCount, compare);
+                    const std::size_t lhsLast = CoRank(last, lhs, lhsCount, rhs, rhsCount, compare);
+                    // Copies, not moves: other threads still binary-search these runs for their own co-ranks
+                    std::merge(lhs + lhsFirst, lhs + lhsLast, rhs + (first - lhsFirst), rhs + (last - lhsLast),
+                               destination + pairStart + first, compare);
+                }
+            });
+
+            std::vector<std::size_t> merged;
+            for (std::size_t run = 0; run < runStarts.size() - 1; run += 2)
+            {
+                merged.push_back(runStarts[run]);
+            }
+            merged.push_back(count);
+            runStarts = std::move(merged);
+            std::swap(source, destination);
+        }
+
+        if (source != elements)
+        {
+            BufferParallel::ForEachRange(count, [&](const std::size_t begin, const std::size_t end)
+            {
+                std::move(source + begin, source + end, elements + begin);
+            });
+        }
+    }
+
+    template<typename T, typename Compare>
+    void Sort(T* elements, const std::size_t count, Compare compare, const bool stable)
+    {
+        // Already sorted or strictly descending input, common with timestamps and ids, costs one scan
+        if (count >= kNetworkLimit)
+        {
+            if (std::is_sorted(elements, elements + count, compare))
+            {
+                return;
+            }
+
+            const auto descending = [&compare](const T& lhs, const T& rhs) { return !compare(rhs, lhs); };
+            if (std::adjacent_find(elements, elements + count, descending) == elements + count)
+            {
+                std::reverse(elements, elements + count);
+                return;
+            }
+        }
+
+        // The merge rounds ping-pong between the buffer and a scratch array of default-constructed elements
+        const bool parallel = std::default_initializable<T> && BufferParallel::IsParallel(count);
+        const bool radix = RadixKey<T> && DefaultOrder<Compare, T> && count >= kRadixLimit;
+        if (!parallel && !radix)
+        {
+            SortRange(elements, static_cast<T*>(nullptr), count, compare, stable);
+            return;
+        }
+
+        if constexpr (std::default_initializable<T>)
+        {
+            std::unique_ptr<T[]> scratch(new T[count]);
+            if (parallel)
+            {
+                ParallelSort(elements, scratch.get(), count, compare, stable);
+            }
+            else
+            {
+                SortRange(elements, scratch.get(), count, compare, stable);
+            }
+        }
+    }
+
+    // indices[i] = position of the i-th smallest element, ties in their original order
+    template<typename T, typename Compare>
+    void ArgSort(const T* elements, unsigned int* indices, const std::size_t count, Compare compare)
+    {
+        std::iota(indices, indices + count, 0u);
+
+        if constexpr (RadixKey<T> && DefaultOrder<Compare, T>)
+        {
+            if (count >= kRadixLimit)
+            {
+                std::unique_ptr<T[]> keys(new T[2 * count]);
+                std::unique_ptr<unsigned int[]> indicesScratch(new unsigned int[count]);
+                std::copy_n(elements, count, keys.get());
+                RadixSort(keys.get(), keys.get() + count, count, indices, indicesScratch.get());
+                return;
+            }
+        }
+
+        std::stable_sort(indices, indices + count, [elements, &compare](const unsigned int lhs, const unsigned int rhs)
+        {
+            return compare(elements[lhs], elements[rhs]);
+        });
+    }
+}
+
+#endif
@@ -4,10 +4,16 @@
 
 // Module 09
 
+#include "LifecycleInstrumentation.h"
+#include "../Basics/FastOutput.h"
+
 #include <iostream>
 #include <chrono>
 #include <algorithm>
 #include <math.h>
+#include <atomic>
+#include <new>
+#include <memory_resource>
 
 using std::cout, std::endl, std::cin, std::string;
 using namespace std::chrono;
@@ -21,27 +27,33 @@ public:
     BasicHuman() : age(1), agesOfChildren(nullptr)
     {
         //age = 1;
+        Lifecycle::Counters<BasicHuman>::Constructed();
     }
 
     // Overloaded constructor that takes a string as a parameter.
     // Constructors can also take default values for parameters, and follow the same rules: defaults always at the end.
     // Use of initialization list (: memberVariable(value)).
     BasicHuman(const string& humanName, const int newAge = 25, const int numberOfChildren = 3)
-        : name(humanName), age(newAge)
+        : name(humanName), age(newAge), childCount(numberOfChildren)
     {
         // Dynamically allocated memory
-        agesOfChildren = new int[numberOfChildren];
+        agesOfChildren = new int[numberOfChildren]();
+        Lifecycle::Counters<BasicHuman>::Constructed();
+        Lifecycle::Counters<BasicHuman>::Allocated(sizeof(int) * numberOfChildren);
     }
 
     // Use of explicit to avoid implicit conversion.
     // Look at line 652 for a deeper explanation of implicit conversion.
     BasicHuman(const int newAge) : age(newAge), agesOfChildren(nullptr)
     {
+        Lifecycle::Counters<BasicHuman>::Constructed();
     }
 
-    BasicHuman(const int newAge, const int numberOfChildren) : age(newAge)
+    BasicHuman(const int newAge, const int numberOfChildren) : age(newAge), childCount(numberOfChildren)
     {
-        agesOfChildren = new int[numberOfChildren];
+        agesOfChildren = new int[numberOfChildren]();
+        Lifecycle::Counters<BasicHuman>::Constructed();
+        Lifecycle::Counters<BasicHuman>::Allocated(sizeof(int) * numberOfChildren);
     }
 
     // Example of "default" constructor that uses default values
@@ -56,7 +68,45 @@ public:
     {
         // Release dynamically allocated memory
         delete[] agesOfChildren;
-        cout << "Cleared memory!" << endl;
+        Lifecycle::Counters<BasicHuman>::Destroyed();
+    }
+
+    // Copy constructor. The implicit one would copy the pointer, and both humans would delete[] the same array.
+    // UseHuman(BasicHuman) takes its argument by value, so every call goes through here.
+    BasicHuman(const BasicHuman& rhs) : name(rhs.name), age(rhs.age), childCount(rhs.childCount)
+    {
+        Lifecycle::Counters<BasicHuman>::Copied();
+        if (rhs.agesOfChildren != nullptr)
+        {
+            agesOfChildren = new int[childCount];
+            Lifecycle::Counters<BasicHuman>::Allocated(sizeof(int) * childCount);
+            std::copy(rhs.agesOfChildren, rhs.agesOfChildren + childCount, agesOfChildren);
+        }
+    }
+
+    BasicHuman(BasicHuman&& rhs) noexcept
+        : name(std::move(rhs.name)), age(rhs.age), agesOfChildren(rhs.agesOfChildren), childCount(rhs.childCount)
+    {
+        Lifecycle::Counters<BasicHuman>::Moved();
+        rhs.agesOfChildren = nullptr;
+        rhs.childCount = 0;
+    }
+
+    BasicHuman& operator=(const BasicHuman& rhs)
+    {
+        if (this != &rhs)
+        {
+            BasicHuman copy(rhs);
+            Swap(copy);
+        }
+
+        return *this;
+    }
+
+    BasicHuman& operator=(BasicHuman&& rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
     }
 
     // Custom methods
@@ -83,9 +133,18 @@ public:
 private:
     string name;
     int age;
-    int* agesOfChildren;
+    int* agesOfChildren = nullptr;
+    int childCount = 0;
     friend void DisplayAge(const BasicHuman& human);
 
+    void Swap(BasicHuman& other) noexcept
+    {
+        std::swap(name, other.name);
+        std::swap(age, other.age);
+        std::swap(agesOfChildren, other.agesOfChildren);
+        std::swap(childCount, other.childCount);
+    }
+
     void Talk(const string& statement)
     {
         cout << statement << endl;
@@ -95,30 +154,39 @@ private:
 class MyBuffer
 {
 public:
-    explicit MyBuffer(const unsigned int length)
+    // Lets callers choose where the integers live: an arena, a pool, or the default heap when nothing is passed
+    using allocator_type = std::pmr::polymorphic_allocator<int>;
+
+    explicit MyBuffer(const unsigned int length, const allocator_type& allocator = {}) : allocator(allocator)
     {
         bufLength = length;
-        cout << "Constructor allocates: " << length << " integers" << endl;
-        myNums = new int[length]; // Dynamic memory!
+        myNums = this->allocator.allocate(length); // Dynamic memory!
+        Lifecycle::Counters<MyBuffer>::Constructed();
+        Lifecycle::Counters<MyBuffer>::Allocated(sizeof(int) * length);
     }
 
     ~MyBuffer()
     {
-        cout << "Destructor called. Clearing memory buffers..." << endl;
-        delete[] myNums; // Deallocate memory, return it to the free memory pool
+        Lifecycle::Counters<MyBuffer>::Destroyed();
+        if (myNums != nullptr)
+        {
+            allocator.deallocate(myNums, bufLength); // Deallocate memory, return it to the memory resource
+        }
     }
 
-    MyBuffer(const MyBuffer& rhs) // Copy constructor
+    // Copy constructor. Like the pmr containers, a copy uses the default resource unless one is passed explicitly
+    MyBuffer(const MyBuffer& rhs, const allocator_type& allocator = {}) : allocator(allocator)
     {
-        cout << "Copy constructor creating deep copy" << endl;
+        Lifecycle::Counters<MyBuffer>::Copied();
         bufLength = rhs.bufLength; // Copy member variables
-        myNums = new int[bufLength]; // Allocate new dynamic memory, with a different address from the original object.
+        myNums = this->allocator.allocate(bufLength); // Allocate new dynamic memory, with a different address from the original object.
+        Lifecycle::Counters<MyBuffer>::Allocated(sizeof(int) * bufLength);
         std::copy(rhs.myNums, rhs.myNums + bufLength, myNums); // Copy values of the original buffer to the new one
     }
 
-    MyBuffer(MyBuffer&& rhs) noexcept // Move constructor
+    MyBuffer(MyBuffer&& rhs) noexcept : allocator(rhs.allocator) // Move constructor, keeps the source's resource
     {
-        cout << "Move constructor was invoked!" << endl;
+        Lifecycle::Counters<MyBuffer>::Moved();
 
         if (rhs.myNums != nullptr)
         {
@@ -129,22 +197,44 @@ public:
         }
     }
 
-    void SetValue(const unsigned int index, const unsigned int value)
+    // Move into a different resource: the memory can only be stolen when both sides share the same resource
+    MyBuffer(MyBuffer&& rhs, const allocator_type& allocator) : allocator(allocator)
     {
-        if (index < bufLength) // Check for bounds
+        Lifecycle::Counters<MyBuffer>::Moved();
+
+        if (rhs.myNums == nullptr)
         {
-            *(myNums + index) = value;
+            return;
         }
+
+        bufLength = rhs.bufLength;
+        if (rhs.allocator == this->allocator)
+        {
+            myNums = rhs.myNums;
+        }
+        else
+        {
+            myNums = this->allocator.allocate(bufLength);
+            Lifecycle::Counters<MyBuffer>::Allocated(sizeof(int) * bufLength);
+            std::copy(rhs.myNums, rhs.myNums + bufLength, myNums);
+            rhs.allocator.deallocate(rhs.myNums, rhs.bufLength);
+        }
+
+        rhs.myNums = nullptr;
+        rhs.bufLength = 0;
     }
 
-    void DisplayBuffer()
+    void SetValue(const unsigned int index, const unsigned int value)
     {
-        for (unsigned counter = 0; counter < bufLength; ++counter)
+        if (index < bufLength) // Check for bounds
         {
-            cout << *(myNums + counter) << "";
+            *(myNums + index) = value;
         }
+    }
 
-        cout << endl;
+    void DisplayBuffer(const std::string_view separator = "")
+    {
+        FastOutput::Display(myNums, bufLength, separator);
     }
 
     void PrintAddress()
@@ -154,9 +244,168 @@ public:
 
     unsigned int GetLength() const { return bufLength; }
 
+    allocator_type get_allocator() const { return allocator; }
+
+private:
+    int* myNums = nullptr;
+    unsigned int bufLength = 0;
+    allocator_type allocator;
+};
+
+// Copy-on-write variant of MyBuffer. Copies share one reference-counted block and only the first write through a
+// shared copy (mutable operator[] or SetValue) clones it. The count is atomic, so copies can be handed to other threads.
+// Once the mutable operator[] has handed out a reference, the block is never shared again: later copies clone it
+// right away, so writes through that reference cannot reach them. A moved-from buffer is empty.
+class CowBuffer
+{
+public:
+    explicit CowBuffer(const unsigned int length) : block(Block::Create(length))
+    {
+        Lifecycle::Counters<CowBuffer>::Constructed();
+    }
+
+    ~CowBuffer()
+    {
+        Lifecycle::Counters<CowBuffer>::Destroyed();
+        Block::Release(block);
+    }
+
+    CowBuffer(const CowBuffer& rhs) : block(rhs.block) // Shares the block, no allocation and no element copy
+    {
+        Lifecycle::Counters<CowBuffer>::Copied();
+        if (block->unshareable)
+        {
+            block = Block::Clone(rhs.block);
+        }
+        else if (block != Block::Empty())
+        {
+            block->references.fetch_add(1, std::memory_order_relaxed);
+            sharedCopies.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    CowBuffer(CowBuffer&& rhs) noexcept : block(rhs.block)
+    {
+        Lifecycle::Counters<CowBuffer>::Moved();
+        rhs.block = Block::Empty();
+    }
+
+    CowBuffer& operator=(const CowBuffer& rhs)
+    {
+        if (this != &rhs)
+        {
+            CowBuffer copy(rhs);
+            std::swap(block, copy.block);
+        }
+
+        return *this;
+    }
+
+    CowBuffer& operator=(CowBuffer&& rhs) noexcept
+    {
+        std::swap(block, rhs.block);
+        return *this;
+    }
+
+    // Reading never clones
+    const int& operator[](const unsigned int index) const
+    {
+        return block->numbers()[index];
+    }
+
+    // Writing may: the caller gets a reference into a block nobody else can see, and that no copy will share
+    int& operator[](const unsigned int index)
+    {
+        MakeUnique();
+        block->unshareable = true;
+        return block->numbers()[index];
+    }
+
+    void SetValue(const unsigned int index, const int value)
+    {
+        if (index < GetLength()) // Check for bounds
+        {
+            MakeUnique();
+            block->numbers()[index] = value;
+        }
+    }
+
+    void DisplayBuffer(const std::string_view separator = " ") const
+    {
+        FastOutput::Display(block->numbers(), GetLength(), separator);
+    }
+
+    unsigned int GetLength() const { return block->length; }
+
+    // How many CowBuffer objects currently share this buffer's block
+    std::size_t UseCount() const
+    {
+        return block != Block::Empty() ? block->references.load(std::memory_order_acquire) : 0;
+    }
+
+    static std::size_t CloneCount() { return cloneEvents.load(std::memory_order_relaxed); }
+    static std::size_t SharedCopyCount() { return sharedCopies.load(std::memory_order_relaxed); }
+
 private:
-    int* myNums;
-    unsigned int bufLength;
+    // Reference count, length and elements in a single allocation
+    struct Block
+    {
+        std::atomic<std::size_t> references{1};
+        unsigned int length = 0;
+        bool unshareable = false; // Set by the mutable operator[], only ever on a block with a single owner
+
+        int* numbers() { return reinterpret_cast<int*>(this + 1); }
+
+        // What moved-from buffers point to: no elements, never counted and never freed
+        static Block* Empty()
+        {
+            static Block empty;
+            return &empty;
+        }
+
+        static Block* Create(const unsigned int length)
+        {
+            void* memory = ::operator new(sizeof(Block) + sizeof(int) * length);
+            Lifecycle::Counters<CowBuffer>::Allocated(sizeof(Block) + sizeof(int) * length);
+            Block* created = new (memory) Block;
+            created->length = length;
+            return created;
+        }
+
+        static Block* Clone(Block* original)
+        {
+            Block* clone = Create(original->length);
+            std::copy(original->numbers(), original->numbers() + original->length, clone->numbers());
+            cloneEvents.fetch_add(1, std::memory_order_relaxed);
+            return clone;
+        }
+
+        static void Release(Block* released)
+        {
+            // acq_rel: the thread that frees the block must see every write made through the other copies
+            if (released != Empty() && released->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                released->~Block();
+                ::operator delete(released);
+            }
+        }
+    };
+
+    Block* block;
+
+    static inline std::atomic<std::size_t> cloneEvents{0};
+    static inline std::atomic<std::size_t> sharedCopies{0};
+
+    void MakeUnique()
+    {
+        // The empty block is shared by every moved-from buffer, so it is always cloned before a write
+        if (block == Block::Empty() || block->references.load(std::memory_order_acquire) > 1)
+        {
+            Block* clone = Block::Clone(block);
+            Block::Release(block);
+            block = clone;
+        }
+    }
 };
 
 void UseHuman(BasicHuman human)
@@ -182,6 +431,19 @@ MyBuffer CopyBuffer(MyBuffer& original)
     return returnCopy; // Return by value invokes copy constructor, again
 }
 
+// Same signatures as UseMyBufferCopy and CopyBuffer, but the by-value copies only bump a reference count
+void UseCowBufferCopy(CowBuffer copyBuffer)
+{
+    cout << "Displaying copy of the copy-on-write buffer:" << endl;
+    copyBuffer.DisplayBuffer();
+}
+
+CowBuffer CopyCowBuffer(const CowBuffer& original)
+{
+    CowBuffer returnCopy(original);
+    return returnCopy;
+}
+
 void DisplayAge(const BasicHuman& human)
 {
     cout << human.age << endl;
@@ -570,6 +832,92 @@ int main_classes()
              */
         }
 
+        // Choosing where the memory comes from
+        {
+            /*
+             * - MyBuffer accepts an optional std::pmr allocator. Buffers that only live for one task can be carved out
+             *   of an arena and released all at once, instead of going to the heap one by one.
+             * - The copy below goes back to the default heap: copies never inherit the source's resource. The move keeps
+             *   the arena, since it simply takes over the memory.
+             * - See the Polymorphic memory resources section in Operators.cpp for a benchmark.
+             */
+
+            std::pmr::monotonic_buffer_resource arena;
+            MyBuffer arenaBuffer(5, &arena);
+            MyBuffer heapCopy(arenaBuffer);
+            MyBuffer arenaMove(std::move(arenaBuffer));
+        }
+
+        // Copy-on-write: sharing copies until somebody writes
+        {
+            /*
+             * - Many copies are only ever read: UseMyBufferCopy just displays its argument, yet the copy constructor
+             *   allocates and copies every element.
+             * - CowBuffer copies share a single reference-counted block instead. The first write through a copy that is
+             *   still shared (mutable operator[] or SetValue) clones the block, so the other copies never see it.
+             * - The count is a std::atomic, so copies can live on different threads. Each object itself is still meant
+             *   to be used by one thread at a time, like any other value type.
+             * - Careful: calling the non-const operator[] clones even if you only read the value. Read through a const
+             *   reference when the buffer may be shared.
+             * - The reference it returns stays valid after later copies are made, so from then on the buffer is never
+             *   shared: copying it clones right away, and writes through the old reference cannot leak into a copy.
+             */
+
+            cout << "\n\nCopy-on-write buffer!" << endl;
+
+            CowBuffer original(5);
+            for (unsigned int i = 0; i < original.GetLength(); ++i)
+            {
+                original.SetValue(i, static_cast<int>(i) * 10);
+            }
+
+            UseCowBufferCopy(original); // No clone, the copy only reads
+            CowBuffer copy(CopyCowBuffer(original));
+            cout << "Copies sharing the block: " << original.UseCount() << endl;
+
+            copy.SetValue(0, -1); // First write through a shared copy: clone
+            cout << "After writing to the copy, clones: " << CowBuffer::CloneCount() << ", original: ";
+            original.DisplayBuffer();
+
+            // Benchmark: a read-mostly workload passes a buffer by value 100000 times and writes on every 1000th call
+            constexpr unsigned int length = 4096;
+            constexpr int calls = 100000;
+            auto readMostly = [](auto& buffer)
+            {
+                long long total = 0;
+                for (int call = 0; call < calls; ++call)
+                {
+                    auto copyOfBuffer = buffer; // What a by-value parameter does
+                    const auto& reader = copyOfBuffer;
+                    if (call % 1000 == 0)
+                    {
+                        copyOfBuffer.SetValue(0, call);
+                    }
+                    else
+                    {
+                        total += reader.GetLength();
+                    }
+                }
+                return total;
+            };
+
+            MyBuffer deepBuffer(length);
+            CowBuffer cowBuffer(length);
+            const std::size_t clonesBefore = CowBuffer::CloneCount();
+
+            const auto deepStart = steady_clock::now();
+            readMostly(deepBuffer);
+            const auto deepTime = duration_cast<microseconds>(steady_clock::now() - deepStart);
+
+            const auto cowStart = steady_clock::now();
+            readMostly(cowBuffer);
+            const auto cowTime = duration_cast<microseconds>(steady_clock::now() - cowStart);
+
+            cout << "Deep copies: " << deepTime.count() << " us" << endl;
+            cout << "Copy-on-write copies: " << cowTime.count() << " us, clones: "
+                << CowBuffer::CloneCount() - clonesBefore << endl;
+        }
+
         // Different uses of constructors and the Destructor
         {
             // A class that does not permit copying.
@@ -1100,6 +1448,13 @@ int main_classes()
     }
 
     SimpleClassImplementation();
+
+    // The classes above record constructions, copies, moves, destructions and allocated bytes instead of printing them.
+    // Build with -DLIFECYCLE_INSTRUMENTATION=1 to fill the counters, the default build compiles the recording away.
+    cout << "\n\n\nLifecycle counters: " << Lifecycle::ToJson({
+        {"BasicHuman", Lifecycle::Counters<BasicHuman>::Take()},
+        {"MyBuffer", Lifecycle::Counters<MyBuffer>::Take()},
+        {"CowBuffer", Lifecycle::Counters<CowBuffer>::Take()}}) << endl;
     return 0;
 }
 
@@ -0,0 +1,412 @@
+//
+// Calendar dates stored as a serial day number: the Date class of the operator overloading lesson
+//
+
+#ifndef DATE_CLASS_H_
+#define DATE_CLASS_H_
+
+#include "../Basics/FastOutput.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace DateClass
+{
+    // Year, month and day of the proleptic Gregorian calendar
+    struct CivilDate
+    {
+        int year;
+        int month; // 1 to 12
+        int day;   // 1 to 31
+    };
+
+    constexpr bool IsLeapYear(const int year)
+    {
+        return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    }
+
+    // month from 1 to 12
+    constexpr int DaysInMonth(const int year, const int month)
+    {
+        constexpr std::array<int, 12> lengths{31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && IsLeapYear(year) ? 29 : lengths[static_cast<std::size_t>(month - 1)];
+    }
+
+    constexpr bool IsValidDate(const int year, const int month, const int day)
+    {
+        return month >= 1 && month <= 12 && day >= 1 && day <= DaysInMonth(year, month);
+    }
+
+    enum class Weekday { Sunday, Monday, Tuesday, Wednesday, Thursday, Friday, Saturday };
+
+    // 1970-01-01 was a Thursday
+    constexpr Weekday WeekdayFromDays(const std::int32_t daysSinceEpoch)
+    {
+        const std::int64_t shifted = std::int64_t{daysSinceEpoch} + 4;
+        return static_cast<Weekday>(shifted >= 0 ? shifted % 7 : (shifted + 1) % 7 + 6);
+    }
+
+    // Conversions between civil dates and serial days counted from 1970-01-01 (day 0). The calendar repeats every 400
+    // years (146097 days), and counting the year from March puts the leap day at the end, so both directions are a few
+    // integer divisions with no loop over months and no table. CivilFromDays accepts every 32-bit day count, and
+    // DaysFromCivil maps each date it returns, -5877641-06-23 to 5881580-07-11, back to the same count (checked at
+    // both ends below). Dates outside that range do not fit in 32 bits.
+    constexpr std::int32_t DaysFromCivil(int year, const int month, const int day)
+    {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const int yearOfEra = year - era * 400;                                               // [0, 399]
+        const int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365], from March
+        const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;   // [0, 146096]
+        return static_cast<std::int32_t>(std::int64_t{era} * 146097 + dayOfEra - 719468);
+    }
+
+    constexpr CivilDate CivilFromDays(const std::int32_t daysSinceEpoch)
+    {
+        const std::int64_t days = std::int64_t{daysSinceEpoch} + 719468; // Days since 0000-03-01
+        const int era = static_cast<int>((days >= 0 ? days : days - 146096) / 146097);
+        const int dayOfEra = static_cast<int>(days - std::int64_t{era} * 146097);
+        const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const int shiftedMonth = (5 * dayOfYear + 2) / 153; // 0 is March
+        const int month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+        return CivilDate{yearOfEra + era * 400 + (month <= 2), month, dayOfYear - (153 * shiftedMonth + 2) / 5 + 1};
+    }
+
+    // "00", "01", ... "99": two digits are copied with one 2-byte load instead of a division each
+    inline constexpr std::array<char, 200> kDigitPairs = []()
+    {
+        std::array<char, 200> pairs{};
+        for (int i = 0; i < 100; ++i)
+        {
+            pairs[2 * i] = static_cast<char>('0' + i / 10);
+            pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+        }
+        return pairs;
+    }();
+
+    inline char* WriteDigitPair(char* out, const int value)
+    {
+        std::memcpy(out, kDigitPairs.data() + 2 * value, 2);
+        return out + 2;
+    }
+
+    // A date is a single 32-bit day number: adding days is one addition that rolls over months and years by itself,
+    // and comparing two dates is one integer comparison. Year, month and day are computed when they are asked for.
+    class Date
+    {
+    private:
+        std::int32_t daysSinceEpoch = 0;
+
+        struct SerialDayTag {};
+        constexpr Date(SerialDayTag, const std::int32_t days) : daysSinceEpoch(days) {}
+
+    public:
+        // Longest ISO-8601 text FormatTo writes: "-5877641-06-23", the first day of a 32-bit day count
+        static constexpr std::size_t kMaxFormattedLength = 16;
+
+        // Out of range months and days roll over: Date(13, 1, 2024) is 2025-01-01 and Date(3, 0, 2024) is 2024-02-29
+        constexpr Date(const int month, const int day, const int year)
+        {
+            const int monthsFromJanuary = month - 1;
+            const int yearCarry = monthsFromJanuary >= 0 ? monthsFromJanuary / 12 : (monthsFromJanuary - 11) / 12;
+            daysSinceEpoch = DaysFromCivil(year + yearCarry, monthsFromJanuary - yearCarry * 12 + 1, 1) + (day - 1);
+        }
+
+        static constexpr Date FromDaysSinceEpoch(const std::int32_t days) { return Date(SerialDayTag{}, days); }
+
+        constexpr std::int32_t DaysSinceEpoch() const { return daysSinceEpoch; }
+        constexpr CivilDate Civil() const { return CivilFromDays(daysSinceEpoch); }
+        constexpr int Year() const { return Civil().year; }
+        constexpr int Month() const { return Civil().month; }
+        constexpr int Day() const { return Civil().day; }
+        constexpr Weekday DayOfWeek() const { return WeekdayFromDays(daysSinceEpoch); }
+
+        // Whether month, day and year name a day of the calendar, without rolling over like the constructor does
+        static constexpr bool IsValid(const int month, const int day, const int year)
+        {
+            return IsValidDate(year, month, day);
+        }
+
+        constexpr Date AddDays(const int days) const { return FromDaysSinceEpoch(daysSinceEpoch + days); }
+
+        // Calendar months: the day stays the same unless the target month is shorter, then it becomes the last day of
+        // that month (January 31 + 1 month is February 28 or 29)
+        constexpr Date AddMonths(const int months) const
+        {
+            const CivilDate civil = Civil();
+            const std::int64_t monthIndex = std::int64_t{civil.year} * 12 + (civil.month - 1) + months;
+            const auto year = static_cast<int>(monthIndex >= 0 ? monthIndex / 12 : (monthIndex - 11) / 12);
+            const int month = static_cast<int>(monthIndex - std::int64_t{year} * 12) + 1;
+            return FromDaysSinceEpoch(DaysFromCivil(year, month, std::min(civil.day, DaysInMonth(year, month))));
+        }
+
+        // February 29 + 1 year is February 28
+        constexpr Date AddYears(const int years) const { return AddMonths(years * 12); }
+
+        // Days from this date to other, negative when other comes first
+        constexpr std::int32_t DaysUntil(const Date& other) const { return other.daysSinceEpoch - daysSinceEpoch; }
+
+        constexpr Date& operator++()
+        {
+            ++daysSinceEpoch;
+            return *this;
+        }
+
+        constexpr Date& operator--()
+        {
+            --daysSinceEpoch;
+            return *this;
+        }
+
+        constexpr Date operator++(int) // postfix increment
+        {
+            Date temp = FromDaysSinceEpoch(daysSinceEpoch);
+            ++daysSinceEpoch;
+            return temp;
+        }
+
+        constexpr Date operator--(int) // postfix decrement
+        {
+            Date temp = FromDaysSinceEpoch(daysSinceEpoch);
+            --daysSinceEpoch;
+            return temp;
+        }
+
+        // Writes the date as ISO-8601, YYYY-MM-DD, and returns the end of the text (no terminating null, like
+        // std::to_chars). Years outside 0 to 9999 get a sign and as many digits as they need. out must have room for
+        // kMaxFormattedLength characters.
+        char* FormatTo(char* out) const
+        {
+            const CivilDate civil = Civil();
+            if (civil.year >= 0 && civil.year <= 9999)
+            {
+                out = WriteDigitPair(out, civil.year / 100);
+                out = WriteDigitPair(out, civil.year % 100);
+            }
+            else
+            {
+                *out++ = civil.year < 0 ? '-' : '+';
+                const unsigned int magnitude = civil.year < 0 ? 0u - static_cast<unsigned int>(civil.year) :
+                    static_cast<unsigned int>(civil.year);
+                if (magnitude < 10000)
+                {
+                    // The expanded form still has at least four year digits: -0044, not -44
+                    out = WriteDigitPair(out, static_cast<int>(magnitude / 100));
+                    out = WriteDigitPair(out, static_cast<int>(magnitude % 100));
+                }
+                else
+                {
+                    out = std::to_chars(out, out + kMaxFormattedLength - 7, magnitude).ptr;
+                }
+            }
+
+            *out++ = '-';
+            out = WriteDigitPair(out, civil.month);
+            *out++ = '-';
+            return WriteDigitPair(out, civil.day);
+        }
+
+        // The text is kept in a small ring of blocks owned by the calling thread, so the date itself stays a plain
+        // number: the pointer stays valid until eight more dates are converted on the same thread. Copy it into a
+        // string to keep it longer.
+        explicit operator const char*() const
+        {
+            constexpr std::size_t kSlots = 8;
+            thread_local std::array<std::array<char, kMaxFormattedLength + 1>, kSlots> slots{};
+            thread_local std::size_t nextSlot = 0;
+
+            char* text = slots[nextSlot++ % kSlots].data();
+            *FormatTo(text) = '\0';
+            return text;
+        }
+
+        // Binary operators
+        constexpr Date operator+(int daysToAdd) const // Binary addition
+        {
+            return FromDaysSinceEpoch(daysSinceEpoch + daysToAdd);
+        }
+
+        constexpr Date operator-(int daysToSub) const // Binary subtraction
+        {
+            return FromDaysSinceEpoch(daysSinceEpoch - daysToSub);
+        }
+
+        // Days from compareTo to this date
+        constexpr std::int32_t operator-(const Date& compareTo) const
+        {
+            return daysSinceEpoch - compareTo.daysSinceEpoch;
+        }
+
+        constexpr void operator+=(int daysToAdd)
+        {
+            daysSinceEpoch += daysToAdd;
+        }
+
+        constexpr void operator-=(int daysToSub)
+        {
+            daysSinceEpoch -= daysToSub;
+        }
+
+        constexpr bool operator==(const Date& compareTo) const
+        {
+            return daysSinceEpoch == compareTo.daysSinceEpoch;
+        }
+
+        constexpr bool operator!=(const Date& compareTo) const
+        {
+            return !this->operator==(compareTo); // Inverse of the result of the equality operator
+        }
+
+        // Conditional checking
+        constexpr bool operator<(const Date& compareTo) const
+        {
+            return daysSinceEpoch < compareTo.daysSinceEpoch;
+        }
+
+        constexpr bool operator<=(const Date& compareTo) const
+        {
+            if(this->operator==(compareTo))
+            {
+                return true;
+            }
+
+            return this->operator<(compareTo);
+        }
+
+        constexpr bool operator>(const Date& compareTo) const
+        {
+            return !this->operator<=(compareTo);
+        }
+
+        constexpr bool operator>=(const Date& compareTo) const
+        {
+            if(this->operator==(compareTo))
+            {
+                return true;
+            }
+
+            return this->operator>(compareTo);
+        }
+
+        // One integer comparison: later dates have larger day numbers
+        constexpr auto operator<=>(const Date& compareTo) const
+        {
+            return daysSinceEpoch <=> compareTo.daysSinceEpoch;
+        }
+
+        void DisplayDate() const
+        {
+            char text[kMaxFormattedLength];
+            std::cout << std::string_view(text, static_cast<std::size_t>(FormatTo(text) - text)) << std::endl;
+        }
+    };
+
+    // Nothing but the day number: dates copy with memcpy and a million of them take 4 MB
+    static_assert(sizeof(Date) == sizeof(std::int32_t) && std::is_trivially_copyable_v<Date>);
+
+    // The n-th (1 for the first) weekday of a month, or the last one for n = -1: Thanksgiving is
+    // NthWeekday(year, 11, Weekday::Thursday, 4). Any other n, or a fifth weekday the month does not have, throws
+    // std::out_of_range; in a constant expression that throw is a compile error instead.
+    constexpr Date NthWeekday(const int year, const int month, const Weekday weekday, const int n)
+    {
+        if (n != -1 && (n < 1 || n > 5))
+        {
+            throw std::out_of_range("NthWeekday: n must be 1 to 5, or -1 for the last one");
+        }
+
+        if (n < 0)
+        {
+            const Date last(month, DaysInMonth(year, month), year);
+            const int back = (static_cast<int>(last.DayOfWeek()) - static_cast<int>(weekday) + 7) % 7;
+            return last - back;
+        }
+
+        const Date first(month, 1, year);
+        const int ahead = (static_cast<int>(weekday) - static_cast<int>(first.DayOfWeek()) + 7) % 7;
+        if (1 + ahead + 7 * (n - 1) > DaysInMonth(year, month))
+        {
+            throw std::out_of_range("NthWeekday: the month has no fifth such weekday");
+        }
+
+        return first + ahead + 7 * (n - 1);
+    }
+
+    // The calendar is checked by the compiler: a mistake in it stops the build instead of reaching a test run
+    static_assert(IsLeapYear(2024) && !IsLeapYear(2023) && !IsLeapYear(1900) && IsLeapYear(2000) && IsLeapYear(-4));
+    static_assert(DaysInMonth(2024, 2) == 29 && DaysInMonth(2023, 2) == 28 && DaysInMonth(2024, 4) == 30 &&
+                  DaysInMonth(2024, 12) == 31);
+    static_assert(Date::IsValid(2, 29, 2024) && !Date::IsValid(2, 29, 2023) && !Date::IsValid(13, 1, 2024) &&
+                  !Date::IsValid(4, 31, 2024) && !Date::IsValid(1, 0, 2024));
+    static_assert(DaysFromCivil(1970, 1, 1) == 0 && DaysFromCivil(2000, 3, 1) == 11017 &&
+                  DaysFromCivil(1969, 12, 31) == -1 && DaysFromCivil(0, 3, 1) == -719468);
+    static_assert(DaysFromCivil(-5877641, 6, 23) == std::numeric_limits<std::int32_t>::min() &&
+                  DaysFromCivil(5881580, 7, 11) == std::numeric_limits<std::int32_t>::max() &&
+                  CivilFromDays(std::numeric_limits<std::int32_t>::max()).year == 5881580);
+    static_assert(CivilFromDays(19962).year == 2024 && CivilFromDays(19962).month == 8 &&
+                  CivilFromDays(19962).day == 27);
+    static_assert(Date(1, 1, 1970).DayOfWeek() == Weekday::Thursday &&
+                  Date(8, 27, 2024).DayOfWeek() == Weekday::Tuesday &&
+                  Date(12, 31, 1969).DayOfWeek() == Weekday::Wednesday &&
+                  Date(1, 1, 1).DayOfWeek() == Weekday::Monday);
+    static_assert(Date(12, 31, 2023) + 1 == Date(1, 1, 2024) && Date(3, 1, 2024) - 1 == Date(2, 29, 2024) &&
+                  Date(13, 1, 2024) == Date(1, 1, 2025) && Date(1, 0, 2024) == Date(12, 31, 2023));
+    static_assert(Date(1, 31, 2024).AddMonths(1) == Date(2, 29, 2024) &&
+                  Date(1, 31, 2023).AddMonths(1) == Date(2, 28, 2023) &&
+                  Date(3, 15, 2024).AddMonths(-3) == Date(12, 15, 2023) &&
+                  Date(2, 29, 2024).AddYears(1) == Date(2, 28, 2025) &&
+                  Date(2, 29, 2024).AddYears(4) == Date(2, 29, 2028));
+    static_assert(Date(1, 1, 2024).DaysUntil(Date(1, 1, 2025)) == 366 && Date(1, 1, 2025) - Date(1, 1, 2024) == 366 &&
+                  Date(1, 1, 2023).DaysUntil(Date(1, 1, 2022)) == -365);
+    static_assert(Date(8, 27, 2024) < Date(8, 28, 2024) && (Date(8, 27, 2024) <=> Date(8, 27, 2024)) == 0);
+    static_assert(NthWeekday(2024, 11, Weekday::Thursday, 4) == Date(11, 28, 2024) &&
+                  NthWeekday(2024, 5, Weekday::Monday, -1) == Date(5, 27, 2024) &&
+                  NthWeekday(2024, 9, Weekday::Monday, 1) == Date(9, 2, 2024));
+
+    // Writes every date as ISO-8601 followed by separator. The text is assembled in a block on the stack and handed to
+    // the sink a block at a time, so exporting millions of dates allocates nothing.
+    inline void FormatDates(const std::span<const Date> dates, FastOutput::OutputSink& sink,
+                            const std::string_view separator = "\n")
+    {
+        constexpr std::size_t kBlockSize = 4096;
+        char block[kBlockSize];
+        std::size_t used = 0;
+
+        for (const Date& date : dates)
+        {
+            if (kBlockSize - used < Date::kMaxFormattedLength)
+            {
+                sink.Write(std::string_view(block, used));
+                used = 0;
+            }
+            used = static_cast<std::size_t>(date.FormatTo(block + used) - block);
+
+            if (kBlockSize - used < separator.size())
+            {
+                sink.Write(std::string_view(block, used));
+                used = 0;
+                if (separator.size() > kBlockSize)
+                {
+                    sink.Write(separator);
+                    continue;
+                }
+            }
+            used += separator.copy(block + used, separator.size());
+        }
+
+        sink.Write(std::string_view(block, used));
+    }
+}
+
+#endif
@@ -0,0 +1,275 @@
+//
+// ISO-8601 date parsing: one date at a time, or a whole buffer of lines with SSE/AVX2
+//
+
+#ifndef DATE_PARSER_H_
+#define DATE_PARSER_H_
+
+#include "BufferClass.h"
+#include "BufferKernels.h"
+#include "DateClass.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+// Dates from text. Parse reads one date in any of the layouts it accepts; ParseLines reads a whole newline-delimited
+// buffer into a column of day numbers, parsing the fixed YYYY-MM-DD layout 16 (SSE) or 32 (AVX2) bytes at a time.
+namespace DateParser
+{
+    namespace Detail
+    {
+        // The day number of year-month-day when that date exists
+        // First and last dates a 32-bit day number can hold, -5877641-06-23 and +5881580-07-11
+        inline constexpr DateClass::CivilDate kFirstDate = DateClass::CivilFromDays(
+            std::numeric_limits<std::int32_t>::min());
+        inline constexpr DateClass::CivilDate kLastDate = DateClass::CivilFromDays(
+            std::numeric_limits<std::int32_t>::max());
+
+        constexpr bool IsBefore(const int year, const int month, const int day, const DateClass::CivilDate& civil)
+        {
+            return year != civil.year ? year < civil.year : month != civil.month ? month < civil.month :
+                day < civil.day;
+        }
+
+        inline std::optional<std::int32_t> DaysIfValid(const int year, const int month, const int day)
+        {
+            if (!DateClass::IsValidDate(year, month, day) || IsBefore(year, month, day, kFirstDate) ||
+                IsBefore(kLastDate.year, kLastDate.month, kLastDate.day, DateClass::CivilDate{year, month, day}))
+            {
+                return std::nullopt;
+            }
+
+            return DateClass::DaysFromCivil(year, month, day);
+        }
+
+        // Value of count ASCII digits, or -1 when one of them is not a digit
+        inline int Digits(const char* text, const std::size_t count)
+        {
+            int value = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const unsigned int digit = static_cast<unsigned char>(text[i]) - static_cast<unsigned int>('0');
+                if (digit > 9)
+                {
+                    return -1;
+                }
+                value = value * 10 + static_cast<int>(digit);
+            }
+
+            return value;
+        }
+
+#ifdef BUFFER_KERNELS_X86
+        inline bool HasShuffleInstruction()
+        {
+            static const bool supported = __builtin_cpu_supports("ssse3");
+            return supported;
+        }
+
+        // Byte positions of the eight digits of YYYY-MM-DD, and of its two dashes
+        inline constexpr unsigned int kDigitPositions = 0b11'0110'1111;
+        inline constexpr unsigned int kDashPositions = 0b1001'0000;
+
+        // Parses YYYY-MM-DD from the first 10 of 16 readable bytes. One compare checks that the eight digits are
+        // digits, one that the dashes are dashes; a shuffle gathers the digits and two multiply-adds turn them into
+        // the year and the month and day as two-digit numbers.
+        __attribute__((target("ssse3"))) inline std::optional<std::int32_t> ParseFixedSSE(const char* text)
+        {
+            const __m128i characters = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+            const __m128i digits = _mm_sub_epi8(characters, _mm_set1_epi8('0'));
+            const __m128i nine = _mm_set1_epi8(9);
+            const auto digitMask = static_cast<unsigned int>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_max_epu8(digits, nine), nine)));
+            const auto dashMask = static_cast<unsigned int>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(characters, _mm_set1_epi8('-'))));
+            if ((digitMask & kDigitPositions) != kDigitPositions || (dashMask & kDashPositions) != kDashPositions)
+            {
+                return std::nullopt;
+            }
+
+            // Y Y Y Y M M D D, then YY YY MM DD as 16-bit numbers, then YYYY
+            const __m128i gathered = _mm_shuffle_epi8(digits, _mm_setr_epi8(0, 1, 2, 3, 5, 6, 8, 9, -1, -1, -1, -1,
+                                                                            -1, -1, -1, -1));
+            const __m128i pairs = _mm_maddubs_epi16(gathered, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 0, 0, 0, 0,
+                                                                            0, 0, 0, 0));
+            const int year = _mm_cvtsi128_si32(_mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 0, 0, 0, 0, 0, 0)));
+            return DaysIfValid(year, _mm_extract_epi16(pairs, 2), _mm_extract_epi16(pairs, 3));
+        }
+
+        // The same for two dates at once, one in each 128-bit lane: first and second each need 16 readable bytes.
+        // Writes both day numbers and returns true only when both dates are valid.
+        __attribute__((target("avx2"))) inline bool ParseTwoFixedAVX2(const char* first, const char* second,
+                                                                      std::int32_t* days)
+        {
+            const __m256i characters = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(second)), 1);
+            const __m256i digits = _mm256_sub_epi8(characters, _mm256_set1_epi8('0'));
+            const __m256i nine = _mm256_set1_epi8(9);
+            const auto digitMask = static_cast<unsigned int>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_max_epu8(digits, nine), nine)));
+            const auto dashMask = static_cast<unsigned int>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(characters, _mm256_set1_epi8('-'))));
+            constexpr unsigned int bothDigits = kDigitPositions | kDigitPositions << 16;
+            constexpr unsigned int bothDashes = kDashPositions | kDashPositions << 16;
+            if ((digitMask & bothDigits) != bothDigits || (dashMask & bothDashes) != bothDashes)
+            {
+                return false;
+            }
+
+            const __m256i gathered = _mm256_shuffle_epi8(digits, _mm256_setr_epi8(
+                0, 1, 2, 3, 5, 6, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1,
+                0, 1, 2, 3, 5, 6, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1));
+            const __m256i pairs = _mm256_maddubs_epi16(gathered, _mm256_setr_epi8(
+                10, 1, 10, 1, 10, 1, 10, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+                10, 1, 10, 1, 10, 1, 10, 1, 0, 0, 0, 0, 0, 0, 0, 0));
+            const __m256i years = _mm256_madd_epi16(pairs, _mm256_setr_epi16(100, 1, 0, 0, 0, 0, 0, 0,
+                                                                              100, 1, 0, 0, 0, 0, 0, 0));
+
+            alignas(32) std::int16_t fields[16];
+            alignas(32) std::int32_t yearFields[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(fields), pairs);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(yearFields), years);
+
+            const std::optional<std::int32_t> firstDays = DaysIfValid(yearFields[0], fields[2], fields[3]);
+            const std::optional<std::int32_t> secondDays = DaysIfValid(yearFields[4], fields[10], fields[11]);
+            if (!firstDays || !secondDays)
+            {
+                return false;
+            }
+
+            days[0] = *firstDays;
+            days[1] = *secondDays;
+            return true;
+        }
+#endif
+    }
+
+    // Accepts YYYY-MM-DD, the basic YYYYMMDD, and years outside 0000 to 9999 written with a sign and 4 to 7 digits
+    // (+10000-01-01, -0044-03-15), which covers everything Date::FormatTo writes. Returns nullopt for anything else,
+    // for dates that do not exist, such as 2023-02-29, and for dates outside the range of a 32-bit day number.
+    inline std::optional<DateClass::Date> Parse(const std::string_view text)
+    {
+        std::size_t position = 0;
+        const bool hasSign = !text.empty() && (text[0] == '+' || text[0] == '-');
+        position += hasSign;
+
+        std::size_t yearDigits = 0;
+        while (position + yearDigits < text.size() && text[position + yearDigits] >= '0' &&
+               text[position + yearDigits] <= '9')
+        {
+            ++yearDigits;
+        }
+
+        std::optional<std::int32_t> days;
+        if (!hasSign && yearDigits == 8 && text.size() == 8)
+        {
+            days = Detail::DaysIfValid(Detail::Digits(text.data(), 4), Detail::Digits(text.data() + 4, 2),
+                                       Detail::Digits(text.data() + 6, 2));
+        }
+        else if ((hasSign ? yearDigits >= 4 && yearDigits <= 7 : yearDigits == 4) &&
+                 text.size() == position + yearDigits + 6 && text[position + yearDigits] == '-' &&
+                 text[position + yearDigits + 3] == '-')
+        {
+            const char* fields = text.data() + position + yearDigits;
+            const int month = Detail::Digits(fields + 1, 2);
+            const int day = Detail::Digits(fields + 4, 2);
+            if (month >= 0 && day >= 0)
+            {
+                const int year = Detail::Digits(text.data() + position, yearDigits);
+                days = Detail::DaysIfValid(text[0] == '-' ? -year : year, month, day);
+            }
+        }
+
+        if (!days)
+        {
+            return std::nullopt;
+        }
+
+        return DateClass::Date::FromDaysSinceEpoch(*days);
+    }
+
+    struct ParsedColumn
+    {
+        BufferClass::MyBuffer<std::int32_t> days; // Day numbers of the valid lines, in order
+        std::size_t invalidLines = 0;             // Non-empty lines that did not hold a date
+    };
+
+    // Parses one date per line ("\n" or "\r\n" endings, empty lines skipped). Lines in the fixed YYYY-MM-DD layout go
+    // through the SIMD parsers, two per step with AVX2; any other line goes through Parse. The vector loads read up to
+    // 16 bytes from the start of a line, so they are only used where that many bytes of text remain.
+    inline ParsedColumn ParseLines(const std::string_view text)
+    {
+        constexpr std::size_t kFixedLine = 11; // YYYY-MM-DD\n
+
+        // A valid line has at least 9 bytes, so this is room enough; the spare capacity is given back at the end
+        ParsedColumn column{BufferClass::MyBuffer<std::int32_t>(static_cast<unsigned int>(text.size() / 9 + 1))};
+        std::int32_t* days = column.days.Data();
+        unsigned int count = 0;
+
+        const char* data = text.data();
+        const std::size_t size = text.size();
+        std::size_t position = 0;
+#ifdef BUFFER_KERNELS_X86
+        const BufferKernels::KernelLevel level = BufferKernels::ActiveTable()->level;
+        const bool useAVX2 = level == BufferKernels::KernelLevel::AVX2;
+        const bool useSSE = level != BufferKernels::KernelLevel::Scalar && Detail::HasShuffleInstruction();
+#endif
+
+        while (position < size)
+        {
+#ifdef BUFFER_KERNELS_X86
+            if (useAVX2)
+            {
+                while (position + kFixedLine + 16 <= size && data[position + 10] == '\n' &&
+                       data[position + kFixedLine + 10] == '\n' &&
+                       Detail::ParseTwoFixedAVX2(data + position, data + position + kFixedLine, days + count))
+                {
+                    count += 2;
+                    position += 2 * kFixedLine;
+                }
+            }
+
+            if (useSSE && position + 16 <= size && data[position + 10] == '\n')
+            {
+                if (const std::optional<std::int32_t> parsed = Detail::ParseFixedSSE(data + position))
+                {
+                    days[count++] = *parsed;
+                    position += kFixedLine;
+                    continue;
+                }
+            }
+#endif
+            const void* newline = std::memchr(data + position, '\n', size - position);
+            const std::size_t lineEnd = newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - data)
+                                                : size;
+            std::string_view line(data + position, lineEnd - position);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+
+            if (!line.empty())
+            {
+                if (const std::optional<DateClass::Date> date = Parse(line))
+                {
+                    days[count++] = date->DaysSinceEpoch();
+                }
+                else
+                {
+                    ++column.invalidLines;
+                }
+            }
+            position = lineEnd + 1;
+        }
+
+        column.days.Resize(count);
+        column.days.ShrinkToFit();
+        return column;
+    }
+}
+
+#endif
@@ -0,0 +1,287 @@
+//
+// Date columns with bitmap range filters and min/max zone maps
+//
+
+#ifndef DATE_SERIES_H_
+#define DATE_SERIES_H_
+
+#include "BufferClass.h"
+#include "BufferCodecs.h"
+#include "BufferFile.h"
+#include "BufferKernels.h"
+#include "DateClass.h"
+#include "DateParser.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Date columns for time-range queries. The dates are day numbers stored one after the other, filters compare a
+// register of them per instruction and return a bitmap, and a min/max zone map per block skips blocks a filter cannot
+// select any date from (or selects every date of) without reading them.
+namespace DateSeries
+{
+    // One bit per date of a column, set for the dates a filter selected
+    class Selection
+    {
+    private:
+        friend class DateColumn;
+
+        BufferClass::MyBuffer<std::uint64_t> words;
+        unsigned int length = 0;
+
+    public:
+        explicit Selection(const unsigned int length) : words((length + 63) / 64), length(length) {}
+
+        unsigned int GetLength() const { return length; }
+
+        bool Contains(const unsigned int index) const { return (words[index / 64] >> (index % 64) & 1) != 0; }
+
+        std::size_t Count() const
+        {
+            std::size_t selected = 0;
+            for (unsigned int word = 0; word < words.GetLength(); ++word)
+            {
+                selected += static_cast<std::size_t>(std::popcount(words[word]));
+            }
+
+            return selected;
+        }
+
+        // Dates selected by both filters, or by either. Both selections must come from the same column.
+        Selection operator&(const Selection& other) const
+        {
+            Selection both(length);
+            for (unsigned int word = 0; word < words.GetLength(); ++word)
+            {
+                both.words[word] = words[word] & other.words[word];
+            }
+
+            return both;
+        }
+
+        Selection operator|(const Selection& other) const
+        {
+            Selection either(length);
+            for (unsigned int word = 0; word < words.GetLength(); ++word)
+            {
+                either.words[word] = words[word] | other.words[word];
+            }
+
+            return either;
+        }
+
+        // Calls function(index) for every selected date, in order. Zero words are skipped whole.
+        template<typename Function>
+        void ForEach(Function function) const
+        {
+            for (unsigned int word = 0; word < words.GetLength(); ++word)
+            {
+                for (std::uint64_t bits = words[word]; bits != 0; bits &= bits - 1)
+                {
+                    function(word * 64 + static_cast<unsigned int>(std::countr_zero(bits)));
+                }
+            }
+        }
+    };
+
+    class DateColumn
+    {
+    public:
+        // Dates per zone: a multiple of 64, so every zone fills whole words of a Selection
+        static constexpr unsigned int kZoneLength = 4096;
+
+        struct Zone
+        {
+            std::int32_t min;
+            std::int32_t max;
+        };
+
+    private:
+        BufferClass::MyBuffer<std::int32_t> days;
+        BufferClass::MyBuffer<Zone> zones;
+
+        enum class ZoneMatch { None, Some, All };
+
+        static ZoneMatch Classify(const Zone& zone, const BufferKernels::Predicate<int>& predicate)
+        {
+            const std::int32_t low = predicate.low;
+            const std::int32_t high = predicate.high;
+            switch (predicate.kind)
+            {
+                case BufferKernels::PredicateKind::Equal:
+                    return low < zone.min || low > zone.max ? ZoneMatch::None :
+                        zone.min == low && zone.max == low ? ZoneMatch::All : ZoneMatch::Some;
+                case BufferKernels::PredicateKind::Less:
+                    return zone.min >= low ? ZoneMatch::None : zone.max < low ? ZoneMatch::All : ZoneMatch::Some;
+                case BufferKernels::PredicateKind::Greater:
+                    return zone.max <= low ? ZoneMatch::None : zone.min > low ? ZoneMatch::All : ZoneMatch::Some;
+                case BufferKernels::PredicateKind::Between:
+                    return zone.max < low || zone.min > high ? ZoneMatch::None :
+                        zone.min >= low && zone.max <= high ? ZoneMatch::All : ZoneMatch::Some;
+            }
+            return ZoneMatch::Some;
+        }
+
+        void RebuildZones()
+        {
+            const unsigned int length = days.GetLength();
+            zones = BufferClass::MyBuffer<Zone>((length + kZoneLength - 1) / kZoneLength);
+            for (unsigned int zone = 0; zone < zones.GetLength(); ++zone)
+            {
+                const unsigned int first = zone * kZoneLength;
+                Zone bounds{std::numeric_limits<std::int32_t>::max(), std::numeric_limits<std::int32_t>::min()};
+                BufferKernels::MinMax(days.Data() + first, std::min(kZoneLength, length - first), bounds.min,
+                                      bounds.max);
+                zones[zone] = bounds;
+            }
+        }
+
+        Selection Filter(const BufferKernels::Predicate<int>& predicate) const
+        {
+            const unsigned int length = days.GetLength();
+            Selection selection(length);
+            std::uint64_t* words = selection.words.Data();
+
+            for (unsigned int zone = 0; zone < zones.GetLength(); ++zone)
+            {
+                const unsigned int first = zone * kZoneLength;
+                const unsigned int count = std::min(kZoneLength, length - first);
+                std::uint64_t* zoneWords = words + first / 64;
+                const unsigned int wordCount = (count + 63) / 64;
+
+                switch (Classify(zones[zone], predicate))
+                {
+                    case ZoneMatch::None:
+                        std::fill_n(zoneWords, wordCount, std::uint64_t{0});
+                        break;
+                    case ZoneMatch::All:
+                        std::fill_n(zoneWords, wordCount, ~std::uint64_t{0});
+                        if (count % 64 != 0)
+                        {
+                            zoneWords[wordCount - 1] = (std::uint64_t{1} << (count % 64)) - 1;
+                        }
+                        break;
+                    case ZoneMatch::Some:
+                        BufferKernels::SelectIf(days.Data() + first, count, predicate, zoneWords);
+                        break;
+                }
+            }
+
+            return selection;
+        }
+
+    public:
+        DateColumn() : days(0), zones(0) {}
+
+        // Takes the day numbers as they are, for instance the column of DateParser::ParseLines
+        explicit DateColumn(BufferClass::MyBuffer<std::int32_t> dayNumbers) : days(std::move(dayNumbers)), zones(0)
+        {
+            RebuildZones();
+        }
+
+        explicit DateColumn(const std::span<const DateClass::Date> dates)
+            : days(static_cast<unsigned int>(dates.size())), zones(0)
+        {
+            for (unsigned int i = 0; i < days.GetLength(); ++i)
+            {
+                days[i] = dates[i].DaysSinceEpoch();
+            }
+            RebuildZones();
+        }
+
+        void PushBack(const DateClass::Date& date)
+        {
+            const std::int32_t day = date.DaysSinceEpoch();
+            if (days.GetLength() % kZoneLength == 0)
+            {
+                zones.PushBack(Zone{day, day});
+            }
+            else
+            {
+                Zone& zone = zones[zones.GetLength() - 1];
+                zone.min = std::min(zone.min, day);
+                zone.max = std::max(zone.max, day);
+            }
+            days.PushBack(day);
+        }
+
+        unsigned int GetLength() const { return days.GetLength(); }
+        DateClass::Date operator[](const unsigned int index) const
+        {
+            return DateClass::Date::FromDaysSinceEpoch(days[index]);
+        }
+
+        const BufferClass::MyBuffer<std::int32_t>& Days() const { return days; }
+        const BufferClass::MyBuffer<Zone>& Zones() const { return zones; }
+
+        // Filters, all bounds inclusive except Before and After, which exclude the date itself
+        Selection Equals(const DateClass::Date& date) const
+        {
+            return Filter(BufferKernels::Predicate<int>::Equal(date.DaysSinceEpoch()));
+        }
+
+        Selection Before(const DateClass::Date& date) const
+        {
+            return Filter(BufferKernels::Predicate<int>::Less(date.DaysSinceEpoch()));
+        }
+
+        Selection After(const DateClass::Date& date) const
+        {
+            return Filter(BufferKernels::Predicate<int>::Greater(date.DaysSinceEpoch()));
+        }
+
+        Selection Between(const DateClass::Date& first, const DateClass::Date& last) const
+        {
+            return Filter(BufferKernels::Predicate<int>::Between(first.DaysSinceEpoch(), last.DaysSinceEpoch()));
+        }
+
+        // Zones Between(first, last) has to read, the others are decided by their min and max alone
+        unsigned int ZonesScanned(const DateClass::Date& first, const DateClass::Date& last) const
+        {
+            const auto predicate = BufferKernels::Predicate<int>::Between(first.DaysSinceEpoch(),
+                                                                          last.DaysSinceEpoch());
+            unsigned int scanned = 0;
+            for (unsigned int zone = 0; zone < zones.GetLength(); ++zone)
+            {
+                scanned += Classify(zones[zone], predicate) == ZoneMatch::Some;
+            }
+
+            return scanned;
+        }
+
+        // Saves the day numbers through a BufferCodecs codec in a BufferFile record. The default, BitPacked, stores the
+        // differences between neighbours: a time series changes by a few days at a time, so they take a few bits each.
+        bool Save(const char* path, const BufferCodecs::Codec codec = BufferCodecs::Codec::BitPacked) const
+        {
+            static_assert(std::is_same_v<std::int32_t, int>, "BufferCodecs encodes int");
+            return BufferFile::Save(BufferCodecs::Encode(days, codec), path);
+        }
+
+        // std::nullopt when the file cannot be read or does not hold an encoded column
+        static std::optional<DateColumn> Load(const char* path)
+        {
+            const std::optional<BufferClass::MyBuffer<std::uint8_t>> encoded = BufferFile::Load<std::uint8_t>(path);
+            if (!encoded)
+            {
+                return std::nullopt;
+            }
+
+            std::optional<BufferClass::MyBuffer<int>> decoded = BufferCodecs::Decode(encoded->Span());
+            if (!decoded)
+            {
+                return std::nullopt;
+            }
+
+            return DateColumn(std::move(*decoded));
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,100 @@
+//
+// Lifecycle counters for the example classes (MyBuffer, BasicHuman, ...)
+//
+
+#ifndef LIFECYCLE_INSTRUMENTATION_H_
+#define LIFECYCLE_INSTRUMENTATION_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+// Build with -DLIFECYCLE_INSTRUMENTATION=1 to count constructions, copies, moves, destructions and allocated bytes.
+// With the default of 0 every recording call is an empty inline function and disappears from the generated code.
+#ifndef LIFECYCLE_INSTRUMENTATION
+#define LIFECYCLE_INSTRUMENTATION 0
+#endif
+
+namespace Lifecycle
+{
+    inline constexpr bool enabled = LIFECYCLE_INSTRUMENTATION != 0;
+
+    struct Snapshot
+    {
+        std::uint64_t constructions = 0;
+        std::uint64_t copies = 0;
+        std::uint64_t moves = 0;
+        std::uint64_t destructions = 0;
+        std::uint64_t bytesAllocated = 0;
+    };
+
+    // One set of counters per instrumented class. Relaxed atomics: the counts are statistics, they do not order
+    // anything, so threads only pay for the increment itself.
+    template<typename Class>
+    class Counters
+    {
+    private:
+        static inline std::atomic<std::uint64_t> constructions{0};
+        static inline std::atomic<std::uint64_t> copies{0};
+        static inline std::atomic<std::uint64_t> moves{0};
+        static inline std::atomic<std::uint64_t> destructions{0};
+        static inline std::atomic<std::uint64_t> bytesAllocated{0};
+
+        static void Add(std::atomic<std::uint64_t>& counter, const std::uint64_t amount)
+        {
+            if constexpr (enabled)
+            {
+                counter.fetch_add(amount, std::memory_order_relaxed);
+            }
+        }
+
+    public:
+        static void Constructed() { Add(constructions, 1); }
+        static void Copied() { Add(copies, 1); }
+        static void Moved() { Add(moves, 1); }
+        static void Destroyed() { Add(destructions, 1); }
+        static void Allocated(const std::size_t bytes) { Add(bytesAllocated, bytes); }
+
+        static Snapshot Take()
+        {
+            return Snapshot{constructions.load(std::memory_order_relaxed), copies.load(std::memory_order_relaxed),
+                            moves.load(std::memory_order_relaxed), destructions.load(std::memory_order_relaxed),
+                            bytesAllocated.load(std::memory_order_relaxed)};
+        }
+
+        static void Reset()
+        {
+            constructions = 0;
+            copies = 0;
+            moves = 0;
+            destructions = 0;
+            bytesAllocated = 0;
+        }
+    };
+
+    // {"MyBuffer":{"constructions":3,...},"BasicHuman":{...}}
+    inline std::string ToJson(const std::initializer_list<std::pair<const char*, Snapshot>> classes)
+    {
+        std::string json = "{";
+        bool first = true;
+
+        for (const auto& [name, snapshot] : classes)
+        {
+            json += first ? "\"" : ",\"";
+            json += name;
+            json += "\":{\"constructions\":" + std::to_string(snapshot.constructions) +
+                ",\"copies\":" + std::to_string(snapshot.copies) +
+                ",\"moves\":" + std::to_string(snapshot.moves) +
+                ",\"destructions\":" + std::to_string(snapshot.destructions) +
+                ",\"bytesAllocated\":" + std::to_string(snapshot.bytesAllocated) + "}";
+            first = false;
+        }
+
+        return json + "}";
+    }
+}
+
+#endif
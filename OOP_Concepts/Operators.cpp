@@ -4,321 +4,78 @@
 
 // Module 12
 
+#include "LifecycleInstrumentation.h"
+#include "../Basics/FastOutput.h"
+#include "BufferClass.h"
+#include "BufferCodecs.h"
+#include "BufferFile.h"
+#include "BufferHash.h"
+#include "BufferKernels.h"
+#include "BufferParallel.h"
+#include "BufferSort.h"
+#include "DateClass.h"
+#include "DateParser.h"
+#include "DateSeries.h"
+#include "RingBuffers.h"
+
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <sstream> // New include that implement ostringstream that is used by cout
 #include <memory>
 #include <random>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <fstream>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using std::cout, std::endl, std::string;
 
-namespace DateClass
+namespace Benchmark
 {
-    class Date
+    // Runs the callable the given number of times and returns the average time per run in microseconds
+    template<typename Callable>
+    double MeasureMicroseconds(Callable&& callable, const int repetitions)
     {
-    private:
-        int year, month, day;
-        string dateInString;
-
-    public:
-        Date(const int month, const int day, const int year) : year(year), month(month), day(day) {}
-
-        Date& operator++()
-        {
-            ++day;
-            return *this;
-        }
-
-        Date& operator--()
-        {
-            --day;
-            return *this;
-        }
-
-        Date operator++(int) // postfix increment
-        {
-            Date temp(month, day,year);
-            ++day;
-            return temp;
-        }
-
-        Date operator--(int) // postfix decrement
-        {
-            Date temp(month, day,year);
-            --day;
-            return temp;
-        }
-
-        explicit operator const char*()
-        {
-            std::ostringstream formattedDate; // Assists during construction
-            formattedDate << year << "/" << month << "/" << day; //ostringstream helps in converting primitives to str
-            dateInString = formattedDate.str();
-            // Stored in member variable because the variable would be destroyed before the compiler returns the value
-            // to the place that invokes the operator.
-            return dateInString.c_str();
-        }
-
-        // Binary operators
-        Date operator+(int daysToAdd) // Binary addition
-        {
-            Date temp(month, day + daysToAdd, year);
-            return temp;
-        }
-
-        Date operator-(int daysToSub) // Binary subtraction
-        {
-            Date temp(month, day - daysToSub, year);
-            return temp;
-        }
-
-        void operator+=(int daysToAdd)
-        {
-            day += daysToAdd;
-        }
-
-        void operator-=(int daysToSub)
-        {
-            day -= daysToSub;
-        }
-
-        bool operator==(const Date& compareTo) const
-        {
-            return ((year == compareTo.year) && (month == compareTo.month) && (day == compareTo.day));
-        }
+        const auto start = std::chrono::steady_clock::now();
 
-        bool operator!=(const Date& compareTo) const
+        for (int i = 0; i < repetitions; ++i)
         {
-            return !this->operator==(compareTo); // Inverse of the result of the equality operator
-        }
-
-        // Conditional checking
-        bool operator<(const Date& compareTo) const
-        {
-            if (year < compareTo.year)
-            {
-                return true;
-            }
-            else if (year == compareTo.year && month < compareTo.month )
-            {
-                return true;
-            }
-            else if (year == compareTo.year && month == compareTo.month && day < compareTo.day)
-            {
-                return true;
-            }
-            else
-            {
-                return false;
-            }
-        }
-
-        bool operator<=(const Date& compareTo) const
-        {
-            if(this->operator==(compareTo))
-            {
-                return true;
-            }
-
-            return this->operator<(compareTo);
-        }
-
-        bool operator>(const Date& compareTo) const
-        {
-            return !this->operator<=(compareTo);
-        }
-
-        bool operator>=(const Date& compareTo) const
-        {
-            if(this->operator==(compareTo))
-            {
-                return true;
-            }
-
-            return this->operator>(compareTo);
-        }
-
-        auto operator<=>(const Date& compareTo) const
-        {
-            if(year < compareTo.year)
-            {
-                return std::strong_ordering::less;
-            }
-            else if(year > compareTo.year)
-            {
-                return std::strong_ordering::greater;
-            }
-            else
-            {
-                // Years are identical. Compare months
-                if (month < compareTo.month)
-                {
-                    return std::strong_ordering::less;
-                }
-                else if (month > compareTo.month)
-                {
-                    return std::strong_ordering::greater;
-                }
-                else
-                {
-                    // Months are identical. Compare days
-                    if (day < compareTo.day)
-                    {
-                        return std::strong_ordering::less;
-                    }
-                    else if (day > compareTo.day)
-                    {
-                        return std::strong_ordering::greater;
-                    }
-                    else
-                    {
-                        return std::strong_ordering::equal;
-                    }
-                }
-            }
+            callable();
         }
 
-        void DisplayDate() const
-        {
-            std::cout << year << "/" << month << "/" << day << std::endl;
-        }
-    };
-}
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / repetitions;
+    }
 
-namespace BufferClass
-{
-    class MyBuffer
+    // Time stamp counter: cycles at the processor's nominal frequency on x86, 0 where there is none
+    inline std::uint64_t CycleCount()
     {
-    private:
-        int* mNumbers = nullptr;
-        unsigned int mSize;
-
-    public:
-        explicit MyBuffer(const unsigned int length) : mSize(length)
-        {
-            mNumbers = new int[mSize]; // Allocate memory
-
-            cout << "Constructing new instance with: " << mSize << " elements." << std::endl;
-        }
-
-        virtual ~MyBuffer()
-        {
-            cout << "Destructor called!" << endl;
-            delete[] mNumbers; // Free allocated memory
-        }
-
-        MyBuffer(const MyBuffer& rhs)
-        {
-            cout << "Copy constructor called!" << endl;
-            if (this != &rhs)
-            {
-                if(mNumbers != nullptr)
-                {
-                    delete[] mNumbers;
-                }
-
-                mSize = rhs.mSize;
-                mNumbers = new int[mSize];
-                std::copy(rhs.mNumbers, rhs.mNumbers + mSize, this->mNumbers);
-            }
-        }
-
-        MyBuffer(MyBuffer&& rhs) noexcept
-        {
-            cout << "Move constructor called!" << endl;
-            if (this != &rhs)
-            {
-                mSize = rhs.mSize;
-                mNumbers = rhs.mNumbers; // We take ownership of the memory pointer! No copy, we just take it
-
-                // Clear source resources after moving them to avoid any issues
-                rhs.mSize = 0;
-                rhs.mNumbers = nullptr;
-            }
-        }
-
-        MyBuffer& operator=(const MyBuffer& rhs)
-        {
-            if (this != &rhs)
-            {
-                cout << "Copy assignment operator" << endl;
-
-                if(mNumbers)
-                {
-                    delete[] mNumbers;
-                }
-
-                mSize = rhs.mSize;
-                mNumbers = new int[mSize];
-                std::copy(rhs.mNumbers, rhs.mNumbers + mSize, this->mNumbers);
-            }
-
-            return *this;
-        }
-
-        MyBuffer& operator=(MyBuffer&& rhs) noexcept
-        {
-            cout << "Move assignment operator" << endl;
-            if (this != &rhs && rhs.mNumbers != nullptr) // Ensure it's not ourselves and something can be moved!
-            {
-                delete[] mNumbers;
-                mSize = rhs.mSize;
-                mNumbers = rhs.mNumbers;
-
-                // Clear source resources after moving them to avoid any issues
-                rhs.mSize = 0;
-                rhs.mNumbers = nullptr;
-            }
-
-            return *this;
-        }
-
-        MyBuffer operator+(const MyBuffer& rhsToAppend)
-        {
-            cout << "Operator+: concatenation of buffers" << endl;
-            MyBuffer temp(this->mSize + rhsToAppend.mSize); // New combined length
-
-            for (int i = 0; i < this->mSize; ++i)
-            {
-                temp[i] = this->mNumbers[i];
-            }
-
-            for (int i = 0; i < rhsToAppend.mSize; ++i)
-            {
-                temp[i + this->mSize] = rhsToAppend.mNumbers[i];
-            }
-
-            return temp;
-        }
-
-        int& operator[](const unsigned int index)
-        {
-            return mNumbers[index];
-        }
-
-        const int& operator[](const unsigned int index) const
-        {
-            return mNumbers[index];
-        }
-
-        void SetValue(const unsigned int index, const int value)
-        {
-            if(index < mSize)
-            {
-                *(mNumbers + index) = value; // + will move pointer forward by n index
-            }
-        }
-
-        void DisplayBuffer() const
-        {
-            for(unsigned int i = 0; i < mSize; ++i)
-            {
-                cout << *(mNumbers + i) << " ";
-            }
-
-            cout << endl;
-        }
-    };
+#ifdef BUFFER_KERNELS_X86
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
 }
 
 namespace Literals
@@ -514,6 +271,10 @@ int operators_main()
                  *
                  * - The operator will also allow us to assign the char* to a string directly, either through an
                  *   assignment operation, or as the parameter of the string constructor.
+                 *
+                 * - The text has to live somewhere after the operator returns. Date keeps it in a few blocks that
+                 *   belong to the calling thread instead of a string member, so each Date is still just 4 bytes.
+                 *   Copy the text into a string when it has to outlive the next conversions.
                  */
 
             }
@@ -806,129 +567,572 @@ int operators_main()
                 cout << "\n\n" << endl;
             }
 
-            // The copy assignment operator
+            // Dates as serial day numbers
             {
                 /*
-                 * - There will be times when you want/need to assign the contents of one object instance into another.
-                 *  - date2 = date
-                 *
-                 * - This assignment invokes the default copy assignment operator that the compiler has built into the
-                 *   class when you don't implement one. As we saw before, classes that managed complex types or
-                 *   dynamically allocated memory, the default copy-constructor is inadequate.
-                 * - In order to ensure deep copies, we need to specify an accompanying copy assignment operator that
-                 *   follows the same logic as the copy constructor.
-
-             classType& operator=(const ClassType& copySource) { if(this != &copySource) { copy logic} return *this}
-
-                 * - This code snippet: if(this != &copySource) protects against copying into itself
+                 * - A date kept as year, month and day makes the simple operations hard: adding a day must know how
+                 *   long the month is and whether the year is a leap year, and comparing needs up to three comparisons.
+                 * - Date keeps one 32-bit number instead, the days since 1970-01-01 (the Unix epoch):
+                 *   - date + n is one addition, and the result is always a valid date (August 31 + 1 is September 1).
+                 *   - Comparisons compare one integer, date2 - date1 is the number of days between them.
+                 *   - Year, month and day are computed when they are needed, by DaysFromCivil and CivilFromDays. The
+                 *     calendar repeats every 400 years, and a year counted from March has the leap day at its end, so
+                 *     the conversion is a handful of integer divisions with no loop and no table.
                  */
 
-                cout << "Copy assignment operator implementation!" << endl;
-
-                BufferClass::MyBuffer buffer(5);
-                std::random_device rd; // Seed random number generator
-                std::mt19937 gen(rd()); // Mersenne Twister engine
-                std::uniform_int_distribution<> dayDist(1, 31);
-                // Used to generate random integers within specified ranges
-
-                for(unsigned int i = 0; i < 5; i++)
+                cout << "Dates as serial day numbers!" << endl;
+
+                DateClass::Date newYearsEve(12, 31, 2023);
+                DateClass::Date leapDay = DateClass::Date(2, 28, 2024) + 1;
+                cout << "2023-12-31 + 1: " << static_cast<const char*>(newYearsEve + 1) << ", 2024-02-28 + 1: "
+                    << static_cast<const char*>(leapDay) << ", 2024-03-01 - 1: "
+                    << static_cast<const char*>(DateClass::Date(3, 1, 2024) - 1) << endl;
+                cout << "Date(13, 1, 2024): " << static_cast<const char*>(DateClass::Date(13, 1, 2024))
+                    << ", days from 2024-01-01 to 2024-12-25: "
+                    << DateClass::Date(12, 25, 2024) - DateClass::Date(1, 1, 2024)
+                    << ", day number of 2024-08-27: " << DateClass::Date(8, 27, 2024).DaysSinceEpoch() << endl;
+
+                // Every day from year -800 to 3200 converts to year, month and day and back to the same number, one
+                // day after the other
+                unsigned int mismatches = 0;
+                const std::int32_t firstDay = DateClass::DaysFromCivil(-800, 1, 1);
+                const std::int32_t lastDay = DateClass::DaysFromCivil(3200, 1, 1);
+                DateClass::CivilDate previous = DateClass::CivilFromDays(firstDay - 1);
+                for (std::int32_t days = firstDay; days < lastDay; ++days)
                 {
-                    buffer.SetValue(i, dayDist(gen));
+                    const DateClass::CivilDate civil = DateClass::CivilFromDays(days);
+                    const bool nextDay = civil.day == previous.day + 1 && civil.month == previous.month &&
+                        civil.year == previous.year;
+                    const bool nextMonth = civil.day == 1 && (civil.month == previous.month + 1 ||
+                                                              (civil.month == 1 && previous.month == 12 &&
+                                                               civil.year == previous.year + 1));
+                    mismatches += DateClass::DaysFromCivil(civil.year, civil.month, civil.day) != days ||
+                        !(nextDay || nextMonth);
+                    previous = civil;
                 }
+                cout << "Round trips from year -800 to 3200: " << mismatches << " mismatches" << endl;
 
-                cout << "Displaying original buffer: " << endl;
-                buffer.DisplayBuffer();
-
-                BufferClass::MyBuffer copyBuffer{1};
+                // Benchmark: how many of a million dates fall before a cutoff, compared field by field or as one number
+                struct FieldDate
+                {
+                    int year, month, day;
 
-                cout << "Displaying copy buffer before copy assignment: " << endl;
-                copyBuffer.DisplayBuffer();
+                    bool operator<(const FieldDate& compareTo) const
+                    {
+                        if (year != compareTo.year)
+                        {
+                            return year < compareTo.year;
+                        }
 
-                copyBuffer = buffer; // Copy assignment operator!
+                        return month != compareTo.month ? month < compareTo.month : day < compareTo.day;
+                    }
+                };
 
-                cout << "Displaying copy buffer after copy assignment: " << endl;
-                copyBuffer.DisplayBuffer();
+                std::mt19937 generator(29);
+                std::vector<FieldDate> fieldDates;
+                std::vector<DateClass::Date> dates;
+                fieldDates.reserve(1'000'000);
+                dates.reserve(1'000'000);
+                for (int i = 0; i < 1'000'000; ++i)
+                {
+                    const DateClass::Date date = DateClass::Date::FromDaysSinceEpoch(
+                        static_cast<std::int32_t>(generator() % 30'000));
+                    const DateClass::CivilDate civil = date.Civil();
+                    fieldDates.push_back(FieldDate{civil.year, civil.month, civil.day});
+                    dates.push_back(date);
+                }
 
-                cout << "Displaying original buffer: " << endl;
-                buffer.DisplayBuffer();
+                const FieldDate fieldCutoff{2000, 6, 15};
+                const DateClass::Date cutoff(6, 15, 2000);
+                std::size_t before = 0;
+                const double fieldTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    before += static_cast<std::size_t>(std::count_if(fieldDates.begin(), fieldDates.end(),
+                        [&](const FieldDate& date) { return date < fieldCutoff; }));
+                }, 10);
+                const double serialTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    before -= static_cast<std::size_t>(std::count_if(dates.begin(), dates.end(),
+                        [&](const DateClass::Date& date) { return date < cutoff; }));
+                }, 10);
+                cout << "Dates before 2000-06-15 among a million, year/month/day: " << fieldTime
+                    << " us, day number: " << serialTime << " us (difference " << before << ")" << endl;
             }
             cout << "\n\n" << endl;
 
-            // The subscript operator
+            // Formatting dates without allocating
             {
                 /*
-                 * - This is the operator that allows array-style access to a class. The typical syntax is as follows:
-                 *  - return_type& operator[](subscript_type& subscript);
-                 *
-                 * - When creating classes that encapsulate a dynamic array of any kind, the subscript operator makes it
-                 *   easy to access a specific index from the collection.
-                 *
-                 * - Add const to operator declaration to prevent changes from happening outside the class.
-                 *
-                 * - Const method/operator implementation will be needed in order for const variables to be declared!
-                 *  - You can declare both versions of the method to support const instances and dynamic instances.
-                 *  - Dynamic: int& operator[](const unsigned int index) - Allows for modifications.
-                 *  - Static: const int& operator[](const unsigned int index) const - No modifications allowed
+                 * - Printing a date through std::ostringstream builds a stream (with its locale), formats three ints
+                 *   one character at a time and allocates a string for the result, for ten characters of text.
+                 * - FormatTo writes YYYY-MM-DD straight into a caller buffer. Every two digits come from a table of
+                 *   the pairs "00" to "99", so four copies of two bytes and two dashes make the whole text.
+                 * - FormatDates formats a whole span of dates into a block on the stack and hands full blocks to a
+                 *   FastOutput::OutputSink: one write(2) per 64 KiB, no allocation at all.
                  */
 
-                cout << "Subscript operator implementation!" << endl;
-
-                BufferClass::MyBuffer buffer(5);
-                std::random_device rd;
-                std::mt19937 gen(rd());
-                std::uniform_int_distribution<> dayDist(1, 31);
-
-                for(unsigned int i = 0; i < 5; i++)
+                cout << "Formatting dates without allocating!" << endl;
+
+                const DateClass::Date release(8, 27, 2024);
+                char text[DateClass::Date::kMaxFormattedLength];
+                const char* textEnd = release.FormatTo(text);
+                cout << "FormatTo: " << std::string_view(text, static_cast<std::size_t>(textEnd - text))
+                    << ", sizeof(Date): " << sizeof(DateClass::Date) << " bytes" << endl;
+
+                const std::array<DateClass::Date, 3> milestones{release, release + 100, DateClass::Date(1, 1, 10000)};
+                cout << "FormatDates: ";
+                cout.flush();
+                FastOutput::OutputSink& standardOutput = FastOutput::StandardOutput();
+                DateClass::FormatDates(milestones, standardOutput, " ");
+                standardOutput.Write('\n');
+                standardOutput.Flush();
+
+                // Years before year 0 keep four digits after the sign, as ISO-8601 expects
+                const std::array<std::pair<DateClass::Date, std::string_view>, 4> negativeYears{{
+                    {DateClass::Date(3, 15, -44), "-0044-03-15"}, {DateClass::Date(1, 1, -1), "-0001-01-01"},
+                    {DateClass::Date(12, 31, -999), "-0999-12-31"}, {DateClass::Date(6, 1, -12345), "-12345-06-01"}}};
+                unsigned int paddingMismatches = 0;
+                cout << "Negative years:";
+                for (const auto& [date, expected] : negativeYears)
                 {
-                    buffer.SetValue(i, dayDist(gen));
+                    const char* end = date.FormatTo(text);
+                    const std::string_view formatted(text, static_cast<std::size_t>(end - text));
+                    paddingMismatches += formatted != expected;
+                    cout << " " << formatted;
                 }
+                cout << " (" << paddingMismatches << " mismatches)" << endl;
 
-                cout << "Displaying buffer through function: " << endl;
-                buffer.DisplayBuffer();
-
-                cout << "Displaying buffer values through subscript operator buffer[i]: " << endl;
-                for(unsigned int i = 0; i < 5; i++)
+                // Benchmark: a million dates to /dev/null, through ostringstream and through FormatDates
+#ifdef MYBUFFER_HAS_MMAP
+                std::vector<DateClass::Date> dates;
+                dates.reserve(1'000'000);
+                for (int i = 0; i < 1'000'000; ++i)
                 {
-                    cout << buffer[i] << endl;
+                    dates.push_back(DateClass::Date::FromDaysSinceEpoch(i % 40'000));
                 }
 
-                cout << "Modifying a value of the buffer through subscript operator: " << endl;
-                buffer[3] =  dayDist(gen);
-
-                buffer.DisplayBuffer();
-
-                const BufferClass::MyBuffer copyBuffer(buffer);
-
-                cout << "Displaying const copy buffer: " << endl;
-                copyBuffer.DisplayBuffer();
+                const int devNull = ::open("/dev/null", O_WRONLY);
+                if (devNull >= 0)
+                {
+                    FastOutput::OutputSink sink(devNull);
+                    const double streamTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        for (const DateClass::Date& date : dates)
+                        {
+                            const DateClass::CivilDate civil = date.Civil();
+                            std::ostringstream formattedDate;
+                            formattedDate << civil.year << "-" << civil.month << "-" << civil.day << "\n";
+                            sink.Write(formattedDate.str());
+                        }
+                        sink.Flush();
+                    }, 1);
+                    const double formatTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        DateClass::FormatDates(dates, sink);
+                        sink.Flush();
+                    }, 1);
 
-                //copyBuffer[3] = 10; // This line prevents compilation because of the const correctness
-                int value = copyBuffer[3]; // You can, however, extract the value and use it for other operations!
-                cout << "Value extracted into another variable from copyBuffer: " <<value << endl;
+                    cout << "A million dates, ostringstream: " << streamTime << " us, FormatDates: " << formatTime
+                        << " us" << endl;
+                }
+                ::close(devNull);
+#endif
             }
             cout << "\n\n" << endl;
 
-            // The function operator ( () )
+            // Parsing dates from text
             {
                 /*
-                 * - The function operator makes objects behave like functions.
-                 * - This operator is heavily used in the Standard Template Library and STL Algorithms.
-                 * - This operator can be used to make decisions, and depending on the number of operands they work on,
-                 *   they can be unary or binary. We call this concept, unary predicate or binary predicate.
-                 *
-                 * - The compiler in this case allows the object to function as a function object, also called a
-                 *   functor. More on this in the FunctionObjects.cpp
+                 * - DateParser::Parse validates one date: the layout (YYYY-MM-DD, YYYYMMDD or a signed year such as
+                 *   +10000-01-01) and the calendar (2023-02-29 does not exist). It returns an optional Date.
+                 * - DateParser::ParseLines reads a log of one date per line into a MyBuffer<std::int32_t> of day
+                 *   numbers. Nearly every line has the fixed layout YYYY-MM-DD, so those are parsed with SIMD:
+                 *   - One 16-byte load holds a whole date. Subtracting '0' from every byte and one unsigned compare
+                 *     checks the eight digits at once, another compare checks the two dashes.
+                 *   - A shuffle gathers the eight digits, and two multiply-add instructions turn them into the year,
+                 *     the month and the day: (2 * 10 + 0) * 100 + (2 * 10 + 4) = 2024.
+                 *   - AVX2 does the same for two lines at once, one in each half of the 256-bit register.
+                 *   - Any other line (another layout, a CRLF ending, the last line of the text) goes through Parse.
                  */
 
-                cout << "Operator () implementation" << endl;
+                cout << "Parsing dates from text!" << endl;
 
-                class Display
+                for (const char* text : {"2024-02-29", "2023-02-29", "20240827", "+10000-01-01", "2024-8-27"})
                 {
-                public:
-                    void operator()(const string& inputString) const
-                    {
-                        cout << inputString << endl;
-                    }
+                    const std::optional<DateClass::Date> date = DateParser::Parse(text);
+                    cout << text << " -> " << (date ? static_cast<const char*>(*date) : "invalid") << "  ";
+                }
+                cout << endl;
+
+                const DateParser::ParsedColumn sample = DateParser::ParseLines("2024-08-27\n2024-02-30\r\n\n19991231\n"
+                                                                               "2000-01-01\r\n");
+                cout << "ParseLines: " << sample.days.GetLength() << " dates, " << sample.invalidLines
+                    << " invalid line(s), day numbers: ";
+                sample.days.DisplayBuffer();
+
+                // Whatever FormatTo writes, Parse reads back to the same day: every day around year 0 (where the
+                // signed, zero-padded years start), every day at both ends of the 32-bit range, and every 997th day
+                // in between
+                unsigned int roundTripMismatches = 0;
+                std::size_t roundTrips = 0;
+                auto roundTrip = [&](const std::int32_t days)
+                {
+                    char text[DateClass::Date::kMaxFormattedLength];
+                    const DateClass::Date date = DateClass::Date::FromDaysSinceEpoch(days);
+                    const char* end = date.FormatTo(text);
+                    const std::optional<DateClass::Date> parsed =
+                        DateParser::Parse(std::string_view(text, static_cast<std::size_t>(end - text)));
+                    roundTripMismatches += !parsed || *parsed != date;
+                    ++roundTrips;
+                };
+
+                constexpr std::int32_t firstDay = std::numeric_limits<std::int32_t>::min();
+                constexpr std::int32_t lastDay = std::numeric_limits<std::int32_t>::max();
+                for (std::int32_t days = DateClass::DaysFromCivil(-1100, 1, 1);
+                     days < DateClass::DaysFromCivil(100, 1, 1); ++days)
+                {
+                    roundTrip(days);
+                }
+                for (std::int32_t offset = 0; offset < 1000; ++offset)
+                {
+                    roundTrip(firstDay + offset);
+                    roundTrip(lastDay - offset);
+                }
+                for (std::int64_t days = firstDay; days <= lastDay; days += 997)
+                {
+                    roundTrip(static_cast<std::int32_t>(days));
+                }
+                cout << "FormatTo then Parse over " << roundTrips << " days from "
+                    << static_cast<const char*>(DateClass::Date::FromDaysSinceEpoch(firstDay)) << " to "
+                    << static_cast<const char*>(DateClass::Date::FromDaysSinceEpoch(lastDay)) << ": "
+                    << roundTripMismatches << " mismatches" << endl;
+
+                // Benchmark: two million lines, by hand with sscanf and the Date constructor, then with ParseLines at
+                // every kernel level
+                constexpr unsigned int lines = 2'000'000;
+                std::mt19937 generator(31);
+                std::string log;
+                log.reserve(lines * 11);
+                for (unsigned int i = 0; i < lines; ++i)
+                {
+                    char text[DateClass::Date::kMaxFormattedLength];
+                    const DateClass::Date date = DateClass::Date::FromDaysSinceEpoch(
+                        static_cast<std::int32_t>(generator() % 30'000));
+                    log.append(text, date.FormatTo(text));
+                    log += '\n';
+                }
+
+                std::int64_t checksum = 0;
+                const double scanfTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    // sscanf measures the length of its input on every call: each line is copied out first, or the
+                    // whole remaining log would be scanned two million times
+                    char line[12] = {};
+                    int year = 0, month = 0, day = 0;
+                    for (unsigned int i = 0; i < lines; ++i)
+                    {
+                        log.copy(line, 10, std::size_t{i} * 11);
+                        if (std::sscanf(line, "%4d-%2d-%2d", &year, &month, &day) == 3)
+                        {
+                            checksum += DateClass::Date(month, day, year).DaysSinceEpoch();
+                        }
+                    }
+                }, 1);
+                cout << "sscanf + Date(month, day, year): " << lines / scanfTime << " M dates/s" << endl;
+
+                const BufferKernels::KernelLevel activeLevel = BufferKernels::ActiveTable()->level;
+                for (const BufferKernels::KernelLevel level : {BufferKernels::KernelLevel::Scalar,
+                                                               BufferKernels::KernelLevel::SSE,
+                                                               BufferKernels::KernelLevel::AVX2})
+                {
+                    if (!BufferKernels::SetLevel(level))
+                    {
+                        continue;
+                    }
+
+                    std::size_t parsed = 0;
+                    const double parseTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        const DateParser::ParsedColumn column = DateParser::ParseLines(log);
+                        parsed = column.days.GetLength();
+                        checksum -= column.days.Sum();
+                    }, 3);
+                    cout << "ParseLines (" << BufferKernels::ActiveTable()->name << "): " << lines / parseTime
+                        << " M dates/s, " << parsed << " parsed" << endl;
+                }
+                BufferKernels::SetLevel(activeLevel);
+                cout << "(checksum " << checksum % 1000 << ")" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Date columns and range filters
+            {
+                /*
+                 * - A std::vector<Date> filtered with operator<=> answers "which dates fall in March?" one date and
+                 *   one branch at a time. DateSeries::DateColumn is built for that question:
+                 *   - The day numbers are stored contiguously in a MyBuffer<std::int32_t>.
+                 *   - Between, Equals, Before and After compare 8 dates per AVX2 instruction (4 with SSE) through the
+                 *     SelectIf kernel and return a Selection: one bit per date, 64 dates per word, combinable with &
+                 *     and |.
+                 *   - Every block of 4096 dates keeps its minimum and maximum (a zone map). A block whose range is
+                 *     outside the query is skipped without reading it, a block entirely inside it is selected whole.
+                 *     Logs are appended in time order, so a query for one month reads only the blocks at its edges.
+                 * - Save writes the column with the BitPacked codec (differences between neighbours, in as few bits
+                 *   as they need) into a BufferFile record, Load maps the file and decodes it.
+                 */
+
+                cout << "Date columns and range filters!" << endl;
+
+                constexpr unsigned int length = 8'000'000;
+                const DateClass::Date start(1, 1, 2015);
+                std::mt19937 generator(37);
+                std::vector<DateClass::Date> dates;
+                dates.reserve(length);
+                DateSeries::DateColumn column;
+                for (unsigned int i = 0; i < length; ++i)
+                {
+                    // About 2700 log lines a day for eight years, a few written up to two days late
+                    const DateClass::Date date = start + static_cast<int>(i / 2700) - static_cast<int>(generator() % 3);
+                    dates.push_back(date);
+                    column.PushBack(date);
+                }
+
+                const DateClass::Date first(3, 1, 2020);
+                const DateClass::Date last(3, 31, 2020);
+                std::size_t selected = 0;
+                const double vectorTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    std::vector<bool> inRange(dates.size());
+                    for (std::size_t i = 0; i < dates.size(); ++i)
+                    {
+                        inRange[i] = (dates[i] <=> first) >= 0 && (dates[i] <=> last) <= 0;
+                    }
+                    selected = static_cast<std::size_t>(std::count(inRange.begin(), inRange.end(), true));
+                }, 3);
+                cout << "vector<Date> + operator<=>: " << vectorTime << " us, " << selected << " dates in March 2020"
+                    << endl;
+
+                const double columnTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    selected = column.Between(first, last).Count();
+                }, 3);
+                cout << "DateColumn::Between: " << columnTime << " us, " << selected << " dates, "
+                    << column.ZonesScanned(first, last) << " of " << column.Zones().GetLength() << " zones read"
+                    << endl;
+
+                // The same dates in random order: every zone spans the eight years, nothing is skipped
+                std::shuffle(dates.begin(), dates.end(), generator);
+                const DateSeries::DateColumn shuffled{std::span<const DateClass::Date>(dates)};
+                const double shuffledTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    selected = shuffled.Between(first, last).Count();
+                }, 3);
+                cout << "DateColumn::Between, shuffled: " << shuffledTime << " us, " << selected << " dates, "
+                    << shuffled.ZonesScanned(first, last) << " zones read" << endl;
+
+                const DateSeries::Selection weekendOfMarch = column.Between(first, last) &
+                    column.Between(DateClass::Date(3, 7, 2020), DateClass::Date(3, 8, 2020));
+                cout << "Between(March) & Between(March 7-8): " << weekendOfMarch.Count() << " dates" << endl;
+
+#ifdef MYBUFFER_HAS_MMAP
+                const std::filesystem::path path = std::filesystem::temp_directory_path() / "operators_dates.bin";
+                if (column.Save(path.c_str()))
+                {
+                    const std::optional<DateSeries::DateColumn> loaded = DateSeries::DateColumn::Load(path.c_str());
+                    cout << "Saved " << std::filesystem::file_size(path) << " bytes for " << length * 4
+                        << " bytes of day numbers, reloaded equal: "
+                        << (loaded && loaded->Days() == column.Days() ? "true" : "false") << endl;
+                }
+                std::filesystem::remove(path);
+#endif
+            }
+            cout << "\n\n" << endl;
+
+            // A calendar computed by the compiler
+            {
+                /*
+                 * - Every part of Date that does not print is constexpr: the constructor, the operators, IsValid,
+                 *   IsLeapYear, DaysInMonth, DayOfWeek, AddDays, AddMonths, AddYears and DaysUntil. The day number
+                 *   is a plain int, so the compiler can run all of them while it compiles.
+                 * - A constexpr table is computed once, at compile time, and stored in the executable as data: a
+                 *   service that needs this year's holidays or a cut-over date does no work for them at startup.
+                 * - static_assert checks a constant expression during the build. The calendar checks next to the
+                 *   Date class stop the build if a rule of the calendar is ever broken.
+                 */
+
+                cout << "A calendar computed by the compiler!" << endl;
+
+                // US federal holidays of 2025 whose date moves with the weekday, built by the compiler
+                constexpr int year = 2025;
+                constexpr std::array<DateClass::Date, 6> holidays{
+                    DateClass::NthWeekday(year, 1, DateClass::Weekday::Monday, 3),   // Martin Luther King Jr. Day
+                    DateClass::NthWeekday(year, 2, DateClass::Weekday::Monday, 3),   // Washington's Birthday
+                    DateClass::NthWeekday(year, 5, DateClass::Weekday::Monday, -1),  // Memorial Day
+                    DateClass::NthWeekday(year, 9, DateClass::Weekday::Monday, 1),   // Labor Day
+                    DateClass::NthWeekday(year, 10, DateClass::Weekday::Monday, 2),  // Columbus Day
+                    DateClass::NthWeekday(year, 11, DateClass::Weekday::Thursday, 4) // Thanksgiving Day
+                };
+                static_assert(holidays[5] == DateClass::Date(11, 27, 2025));
+                static_assert(std::is_sorted(holidays.begin(), holidays.end()));
+
+                cout << "Holidays of " << year << ": ";
+                cout.flush();
+                FastOutput::OutputSink& standardOutput = FastOutput::StandardOutput();
+                DateClass::FormatDates(holidays, standardOutput, " ");
+                standardOutput.Write('\n');
+                standardOutput.Flush();
+
+                // A cut-over date and a schedule derived from it, all constants
+                constexpr DateClass::Date cutOver = DateClass::Date(1, 31, 2025).AddMonths(1);
+                constexpr std::int32_t daysToYearEnd = cutOver.DaysUntil(DateClass::Date(12, 31, 2025));
+                constexpr bool cutOverOnWeekend = cutOver.DayOfWeek() == DateClass::Weekday::Saturday ||
+                    cutOver.DayOfWeek() == DateClass::Weekday::Sunday;
+                static_assert(cutOver == DateClass::Date(2, 28, 2025) && !cutOverOnWeekend);
+                cout << "Cut-over one month after 2025-01-31: " << static_cast<const char*>(cutOver) << ", "
+                    << daysToYearEnd << " days before the end of the year, on a weekend: "
+                    << (cutOverOnWeekend ? "yes" : "no") << endl;
+
+                constexpr std::array<DateClass::Date, 4> quarterlyReviews = [&]()
+                {
+                    std::array<DateClass::Date, 4> reviews{cutOver, cutOver, cutOver, cutOver};
+                    for (int quarter = 0; quarter < 4; ++quarter)
+                    {
+                        reviews[static_cast<std::size_t>(quarter)] = cutOver.AddMonths(3 * quarter);
+                    }
+                    return reviews;
+                }();
+                static_assert(quarterlyReviews[1] == DateClass::Date(5, 28, 2025));
+                cout << "Quarterly reviews: ";
+                cout.flush();
+                DateClass::FormatDates(quarterlyReviews, standardOutput, " ");
+                standardOutput.Write('\n');
+                standardOutput.Flush();
+            }
+            cout << "\n\n" << endl;
+
+            // The copy assignment operator
+            {
+                /*
+                 * - There will be times when you want/need to assign the contents of one object instance into another.
+                 *  - date2 = date
+                 *
+                 * - This assignment invokes the default copy assignment operator that the compiler has built into the
+                 *   class when you don't implement one. As we saw before, classes that managed complex types or
+                 *   dynamically allocated memory, the default copy-constructor is inadequate.
+                 * - In order to ensure deep copies, we need to specify an accompanying copy assignment operator that
+                 *   follows the same logic as the copy constructor.
+
+             classType& operator=(const ClassType& copySource) { if(this != &copySource) { copy logic} return *this}
+
+                 * - This code snippet: if(this != &copySource) protects against copying into itself
+                 */
+
+                cout << "Copy assignment operator implementation!" << endl;
+
+                BufferClass::MyBuffer buffer(5);
+                std::random_device rd; // Seed random number generator
+                std::mt19937 gen(rd()); // Mersenne Twister engine
+                std::uniform_int_distribution<> dayDist(1, 31);
+                // Used to generate random integers within specified ranges
+
+                for(unsigned int i = 0; i < 5; i++)
+                {
+                    buffer.SetValue(i, dayDist(gen));
+                }
+
+                cout << "Displaying original buffer: " << endl;
+                buffer.DisplayBuffer();
+
+                BufferClass::MyBuffer copyBuffer{1};
+
+                cout << "Displaying copy buffer before copy assignment: " << endl;
+                copyBuffer.DisplayBuffer();
+
+                copyBuffer = buffer; // Copy assignment operator!
+
+                cout << "Displaying copy buffer after copy assignment: " << endl;
+                copyBuffer.DisplayBuffer();
+
+                cout << "Displaying original buffer: " << endl;
+                buffer.DisplayBuffer();
+            }
+            cout << "\n\n" << endl;
+
+            // The subscript operator
+            {
+                /*
+                 * - This is the operator that allows array-style access to a class. The typical syntax is as follows:
+                 *  - return_type& operator[](subscript_type& subscript);
+                 *
+                 * - When creating classes that encapsulate a dynamic array of any kind, the subscript operator makes it
+                 *   easy to access a specific index from the collection.
+                 *
+                 * - Add const to operator declaration to prevent changes from happening outside the class.
+                 *
+                 * - Const method/operator implementation will be needed in order for const variables to be declared!
+                 *  - You can declare both versions of the method to support const instances and dynamic instances.
+                 *  - Dynamic: int& operator[](const unsigned int index) - Allows for modifications.
+                 *  - Static: const int& operator[](const unsigned int index) const - No modifications allowed
+                 */
+
+                cout << "Subscript operator implementation!" << endl;
+
+                BufferClass::MyBuffer buffer(5);
+                std::random_device rd;
+                std::mt19937 gen(rd());
+                std::uniform_int_distribution<> dayDist(1, 31);
+
+                for(unsigned int i = 0; i < 5; i++)
+                {
+                    buffer.SetValue(i, dayDist(gen));
+                }
+
+                cout << "Displaying buffer through function: " << endl;
+                buffer.DisplayBuffer();
+
+                cout << "Displaying buffer values through subscript operator buffer[i]: " << endl;
+                for(unsigned int i = 0; i < 5; i++)
+                {
+                    cout << buffer[i] << endl;
+                }
+
+                cout << "Modifying a value of the buffer through subscript operator: " << endl;
+                buffer[3] =  dayDist(gen);
+
+                buffer.DisplayBuffer();
+
+                const BufferClass::MyBuffer copyBuffer(buffer);
+
+                cout << "Displaying const copy buffer: " << endl;
+                copyBuffer.DisplayBuffer();
+
+                //copyBuffer[3] = 10; // This line prevents compilation because of the const correctness
+                int value = copyBuffer[3]; // You can, however, extract the value and use it for other operations!
+                cout << "Value extracted into another variable from copyBuffer: " <<value << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // The function operator ( () )
+            {
+                /*
+                 * - The function operator makes objects behave like functions.
+                 * - This operator is heavily used in the Standard Template Library and STL Algorithms.
+                 * - This operator can be used to make decisions, and depending on the number of operands they work on,
+                 *   they can be unary or binary. We call this concept, unary predicate or binary predicate.
+                 *
+                 * - The compiler in this case allows the object to function as a function object, also called a
+                 *   functor. More on this in the FunctionObjects.cpp
+                 */
+
+                cout << "Operator () implementation" << endl;
+
+                class Display
+                {
+                public:
+                    void operator()(const string& inputString) const
+                    {
+                        cout << inputString << endl;
+                    }
                 };
 
                 Display display;
@@ -995,28 +1199,21 @@ int operators_main()
                 BufferClass::MyBuffer buffer(5);
                 BufferClass::MyBuffer buffer2(15);
 
-                cout << "Concatenate buffers with operator+ overload!" << endl;
-                BufferClass::MyBuffer buffer3(buffer + buffer2);
+                cout << "Concatenate buffers with the pairwise Concatenate method!" << endl;
+                BufferClass::MyBuffer buffer3(buffer.Concatenate(buffer2));
                 BufferClass::MyBuffer buffSum(1);
 
                 cout << "Concatenate buffers with assignment operator!" << endl;
-                buffSum = buffer + buffer2 + buffer3;
+                buffSum = buffer.Concatenate(buffer2).Concatenate(buffer3);
 
                 /*
-                 * - Depending on the compiler you are using, the output message will be different. For this instance,
-                 *   the project has been built with g++. So this is the output:
-                 *   - Constructing new instance with: 5 elements.
-                 *   - Constructing new instance with: 15 elements.
-                 *   - Concatenate buffers with operator+ overload!
-                 *   - Operator+: concatenation of buffers
-                 *   - Constructing new instance with: 20 elements.
-                 *   - Constructing new instance with: 1 elements.
-                 *   - Concatenate buffers with assignment operator!
-                 *   - Operator+: concatenation of buffers
-                 *   - Constructing new instance with: 20 elements.
-                 *   - Operator+: concatenation of buffers
-                 *   - Constructing new instance with: 40 elements.
-                 *   - Move assignment operator -> Move assignment operator was called!
+                 * - MyBuffer records its special member functions in lifecycle counters instead of printing them (see
+                 *   the lifecycle block further down). Built with -DLIFECYCLE_INSTRUMENTATION=1 and g++, this block
+                 *   records:
+                 *   - 6 constructions: buffer(5), buffer2(15), buffSum(1) and the three results of Concatenate (20, 20
+                 *     and 40 elements). Returning them needs neither a copy nor a move, the compiler elides it.
+                 *   - 0 copies.
+                 *   - 1 move: the move assignment of the 40-element temporary into buffSum.
                  *
                  * - The compiler does not automatically generate move constructors and move assignment operators.
                  *   You always have to provide them yourself! In case they are not implemented, the compiler will
@@ -1029,6 +1226,1645 @@ int operators_main()
             }
             cout << "\n\n" << endl;
 
+            // Lazy concatenation with expression templates
+            {
+                /*
+                 * - Move semantics remove the copies of the temporaries, but a chain like a + b + c + d still allocates
+                 *   one temporary per + and copies the leading elements again and again.
+                 * - Expression templates fix that by making operator+ return a lightweight object that only REMEMBERS
+                 *   what has to be concatenated:
+                 *   - a + b       -> BufferConcat<MyBuffer, MyBuffer>
+                 *   - a + b + c   -> BufferConcat<BufferConcat<MyBuffer, MyBuffer>, MyBuffer>
+                 * - The work happens once the expression is used to construct or assign a MyBuffer. At that point the
+                 *   final length is known, so there is a single allocation and each source is copied exactly once.
+                 *
+                 * - Be careful with auto: auto sum = a + b; stores the expression, not a buffer. The expression refers
+                 *   to a and b, so it must be materialized while they are still alive.
+                 */
+
+                cout << "Lazy concatenation with expression templates!" << endl;
+
+                BufferClass::MyBuffer buffer(5);
+                BufferClass::MyBuffer buffer2(15);
+                BufferClass::MyBuffer buffer3(buffer + buffer2); // Materialized by the constructor
+
+                BufferClass::MyBuffer buffSum(1);
+                buffSum = buffer + buffer2 + buffer3; // One allocation of 40 elements, three bulk copies
+
+                // Benchmark: a chain of 24 buffers, pairwise Concatenate against the lazy operator+
+                constexpr unsigned int chainLength = 24;
+                constexpr int repetitions = 20;
+                std::vector<BufferClass::MyBuffer<>> chain;
+                chain.reserve(chainLength);
+
+                for (unsigned int i = 0; i < chainLength; ++i)
+                {
+                    chain.emplace_back(64);
+                }
+
+                const double pairwiseTime = Benchmark::MeasureMicroseconds([&chain]()
+                {
+                    BufferClass::MyBuffer result = chain[0].Concatenate(chain[1]);
+
+                    for (unsigned int i = 2; i < chainLength; ++i)
+                    {
+                        result = result.Concatenate(chain[i]);
+                    }
+                }, repetitions);
+
+                const double lazyTime = Benchmark::MeasureMicroseconds([&chain]()
+                {
+                    BufferClass::MyBuffer result = chain[0] + chain[1] + chain[2] + chain[3] + chain[4] + chain[5] +
+                        chain[6] + chain[7] + chain[8] + chain[9] + chain[10] + chain[11] + chain[12] + chain[13] +
+                        chain[14] + chain[15] + chain[16] + chain[17] + chain[18] + chain[19] + chain[20] +
+                        chain[21] + chain[22] + chain[23];
+                }, repetitions);
+
+                cout << "Pairwise Concatenate of " << chainLength << " buffers: " << pairwiseTime << " us" << endl;
+                cout << "Lazy operator+ of " << chainLength << " buffers: " << lazyTime << " us" << endl;
+
+                /*
+                 * - The pairwise version allocates 23 temporaries and copies the first buffer 23 times. The lazy version
+                 *   allocates once and copies every buffer once, so the gap grows with the length of the chain.
+                 */
+            }
+            cout << "\n\n" << endl;
+
+            // Vectorized bulk kernels
+            {
+                /*
+                 * - Copying, filling and comparing buffers are the same few loops over ints. The BufferKernels
+                 *   namespace implements them three times: a scalar reference, SSE (4 ints per instruction) and AVX2
+                 *   (8 ints per instruction).
+                 * - Which version runs is decided once at runtime with __builtin_cpu_supports, so the same executable
+                 *   works on older CPUs and uses the wide registers when they exist.
+                 * - The copy constructor, copy assignment, Concatenate and the lazy operator+ all copy through
+                 *   BufferKernels::Copy. operator== and operator<=> are built on Equal and Compare, and the numeric
+                 *   operations (Sum, MinMax, Count) on the Sum, MinMax and Count kernels.
+                 *
+                 * - The wide versions must give exactly the same answer as the scalar one. The check below runs every
+                 *   supported level against the scalar reference, for many lengths and misaligned start addresses so
+                 *   that the vector loops and their scalar tails are both exercised.
+                 */
+
+                cout << "Vectorized buffer kernels! Active level: " << BufferKernels::ActiveTable()->name << endl;
+
+                const BufferKernels::KernelLevel startingLevel = BufferKernels::ActiveTable()->level;
+                std::mt19937 gen(42);
+                std::uniform_int_distribution<> valueDist(-3, 3); // Narrow range so equal runs are common
+
+                for (const BufferKernels::KernelLevel level : {BufferKernels::KernelLevel::Scalar,
+                                                               BufferKernels::KernelLevel::SSE,
+                                                               BufferKernels::KernelLevel::AVX2})
+                {
+                    if (!BufferKernels::SetLevel(level))
+                    {
+                        continue;
+                    }
+
+                    int mismatches = 0;
+                    for (std::size_t count = 0; count < 70; ++count)
+                    {
+                        for (std::size_t offset = 0; offset < 4; ++offset)
+                        {
+                            std::vector<int> source(count + offset), lhs(count + offset), rhs(count + offset);
+                            std::vector<int> expected(count + offset), actual(count + offset);
+                            for (std::size_t i = 0; i < source.size(); ++i)
+                            {
+                                source[i] = valueDist(gen);
+                                lhs[i] = valueDist(gen);
+                                rhs[i] = lhs[i];
+                            }
+
+                            if (count > 0)
+                            {
+                                rhs[offset + gen() % count] = valueDist(gen); // Maybe introduce one difference
+                            }
+
+                            BufferKernels::Scalar::Copy(expected.data() + offset, source.data() + offset, count);
+                            BufferKernels::Copy(actual.data() + offset, source.data() + offset, count);
+                            mismatches += expected != actual;
+
+                            BufferKernels::Scalar::Fill(expected.data() + offset, 7, count);
+                            BufferKernels::Fill(actual.data() + offset, 7, count);
+                            mismatches += expected != actual;
+
+                            mismatches += BufferKernels::Scalar::Equal(lhs.data() + offset, rhs.data() + offset, count)
+                                != BufferKernels::Equal(lhs.data() + offset, rhs.data() + offset, count);
+
+                            mismatches += BufferKernels::Scalar::Compare(lhs.data() + offset, rhs.data() + offset, count)
+                                != BufferKernels::Compare(lhs.data() + offset, rhs.data() + offset, count);
+
+                            mismatches += BufferKernels::Scalar::Sum(source.data() + offset, count)
+                                != BufferKernels::Sum(source.data() + offset, count);
+
+                            mismatches += BufferKernels::Scalar::Count(lhs.data() + offset, count, 1)
+                                != BufferKernels::Count(lhs.data() + offset, count, 1);
+
+                            int expectedMin, expectedMax, actualMin, actualMax;
+                            BufferKernels::Scalar::MinMax(source.data() + offset, count, expectedMin, expectedMax);
+                            BufferKernels::MinMax(source.data() + offset, count, actualMin, actualMax);
+                            mismatches += expectedMin != actualMin || expectedMax != actualMax;
+                        }
+                    }
+
+                    // Checked in every build, not only where assert is compiled in
+                    cout << BufferKernels::ActiveTable()->name << " kernels against scalar: " << mismatches
+                        << " mismatches" << endl;
+                    if (mismatches != 0)
+                    {
+                        cout << "FAILED: the " << BufferKernels::ActiveTable()->name
+                            << " kernels disagree with the scalar reference" << endl;
+                    }
+                }
+
+                BufferKernels::SetLevel(startingLevel);
+
+                BufferClass::MyBuffer buffer(8);
+                BufferClass::MyBuffer buffer2(8);
+                buffer.Fill(3);
+                buffer2.Fill(3);
+                cout << "Filled buffers equal: " << (buffer == buffer2) << endl;
+
+                buffer2[7] = 4;
+                cout << "buffer < buffer2 after changing the last element: " << (buffer < buffer2) << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Small-buffer optimization
+            {
+                /*
+                 * - Most buffers are tiny, yet each of them used to pay for a new int[] and a delete[]. A heap
+                 *   allocation is far more expensive than filling a handful of ints.
+                 * - MyBuffer now carries an inline array of kInlineCapacity ints (16 unless MYBUFFER_INLINE_CAPACITY is
+                 *   defined otherwise). A buffer that fits points mNumbers at that array and never allocates.
+                 *
+                 * - Moving changes meaning for inline buffers: there is no pointer to steal because the elements live
+                 *   inside the source object. The move constructor and move assignment therefore copy the inline
+                 *   elements, and only steal the pointer when the source owns a heap block.
+                 */
+
+                cout << "Small-buffer optimization! Inline capacity: " << BufferClass::MyBuffer<>::kInlineCapacity << endl;
+
+                constexpr unsigned int smallLength = BufferClass::MyBuffer<>::kInlineCapacity > 0
+                                                         ? BufferClass::MyBuffer<>::kInlineCapacity / 2
+                                                         : 1;
+                constexpr unsigned int largeLength = BufferClass::MyBuffer<>::kInlineCapacity + 1;
+
+                // Allocation counts: a small buffer, its copy and its moves stay off the heap
+                constexpr bool hasInline = BufferClass::MyBuffer<>::kInlineCapacity > 0;
+                int failedChecks = 0;
+                std::size_t allocationsBefore = BufferClass::MyBuffer<>::HeapAllocationCount();
+                {
+                    BufferClass::MyBuffer small(smallLength);
+                    small.Fill(5);
+                    BufferClass::MyBuffer copied(small);
+                    BufferClass::MyBuffer moved(std::move(copied));
+                    BufferClass::MyBuffer assigned(1);
+                    assigned = std::move(moved);
+                    failedChecks += !(assigned == small && moved.GetLength() == 0);
+                    failedChecks += hasInline && assigned.IsOnHeap();
+                }
+                const std::size_t smallAllocations = BufferClass::MyBuffer<>::HeapAllocationCount() - allocationsBefore;
+                cout << "Heap allocations for a small buffer, copy, move and move assignment: " << smallAllocations
+                    << (hasInline ? " (expected 0)" : "") << endl;
+                failedChecks += hasInline && smallAllocations != 0;
+
+                // A large buffer allocates once, its move steals the block without allocating again
+                allocationsBefore = BufferClass::MyBuffer<>::HeapAllocationCount();
+                {
+                    BufferClass::MyBuffer large(largeLength);
+                    large.Fill(9);
+                    BufferClass::MyBuffer moved(std::move(large));
+                    BufferClass::MyBuffer assigned(0);
+                    assigned = std::move(moved);
+                    failedChecks += !(assigned.IsOnHeap() && assigned.GetLength() == largeLength);
+                }
+                const std::size_t largeAllocations = BufferClass::MyBuffer<>::HeapAllocationCount() - allocationsBefore;
+                cout << "Heap allocations for a large buffer, move and move assignment: " << largeAllocations
+                    << " (expected 1)" << endl;
+                failedChecks += largeAllocations != 1;
+                if (failedChecks != 0)
+                {
+                    cout << "FAILED: " << failedChecks << " small-buffer check(s) did not hold" << endl;
+                }
+
+                // Microbenchmark: create, fill, copy and destroy buffers just below and just above the threshold
+                constexpr int churnRepetitions = 100000;
+                auto churn = [](const unsigned int length)
+                {
+                    BufferClass::MyBuffer buffer(length);
+                    buffer.Fill(1);
+                    BufferClass::MyBuffer copy(buffer);
+                    return copy[0];
+                };
+
+                const double inlineTime =
+                    Benchmark::MeasureMicroseconds([&churn]() { churn(smallLength); }, churnRepetitions);
+                const double heapTime =
+                    Benchmark::MeasureMicroseconds([&churn]() { churn(largeLength); }, churnRepetitions);
+
+                cout << "Churn of " << smallLength << "-element (inline) buffers: " << inlineTime * 1000.0
+                    << " ns per iteration" << endl;
+                cout << "Churn of " << largeLength << "-element (heap) buffers: " << heapTime * 1000.0
+                    << " ns per iteration" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Polymorphic memory resources (std::pmr)
+            {
+                /*
+                 * - new int[] always goes to the general purpose heap. C++17 added std::pmr::memory_resource, an
+                 *   interface for "where memory comes from", so the caller can decide per buffer:
+                 *   - std::pmr::monotonic_buffer_resource: an arena. Allocation is a pointer bump, deallocation does
+                 *     nothing, and everything is released at once when the arena dies. Perfect for request-scoped work.
+                 *   - std::pmr::unsynchronized_pool_resource: pools of fixed-size blocks, single threaded. Freed blocks
+                 *     are reused, which suits long-lived buffers that come and go.
+                 * - MyBuffer takes an optional allocator (a memory_resource* converts to one) and allocates its heap
+                 *   blocks through a std::pmr::polymorphic_allocator<int>. Inline buffers still do not allocate at all.
+                 * - Because MyBuffer declares allocator_type and accepts the allocator as its last constructor argument,
+                 *   a std::pmr::vector<MyBuffer> hands its own resource down to every buffer it creates.
+                 *
+                 * - pmr semantics for copies and moves:
+                 *   - A copy uses the default resource, unless a resource is passed: MyBuffer copy(source, &arena).
+                 *   - A move constructor keeps the source's resource and steals the block.
+                 *   - Assignments keep the destination's resource. A move assignment between different resources has
+                 *     to copy the elements, since a block can only be returned to the resource that created it.
+                 */
+
+                cout << "Polymorphic memory resources!" << endl;
+
+                std::pmr::unsynchronized_pool_resource pool;
+                BufferClass::MyBuffer pooled(64, &pool);
+                pooled.Fill(2);
+
+                BufferClass::MyBuffer defaultCopy(pooled);
+                BufferClass::MyBuffer poolCopy(pooled, &pool);
+                cout << "Plain copy uses the default resource: "
+                    << (defaultCopy.GetResource() == std::pmr::get_default_resource()) << endl;
+                cout << "Allocator-extended copy uses the pool: " << (poolCopy.GetResource() == &pool) << endl;
+
+                BufferClass::MyBuffer heapBuffer(64);
+                heapBuffer = std::move(poolCopy); // Different resources: the elements are copied, heapBuffer stays on the heap
+                cout << "Move assignment across resources keeps the destination resource: "
+                    << (heapBuffer.GetResource() == std::pmr::get_default_resource() && heapBuffer == pooled) << endl;
+
+                // Benchmark: a request builds and drops a few thousand buffers of mixed sizes
+                constexpr int buffersPerRequest = 4000;
+                constexpr int requests = 20;
+                std::vector<unsigned int> lengths(buffersPerRequest);
+                std::mt19937 gen(7);
+                std::uniform_int_distribution<unsigned int> lengthDist(BufferClass::MyBuffer<>::kInlineCapacity + 1, 512);
+                for (unsigned int& length : lengths)
+                {
+                    length = lengthDist(gen);
+                }
+
+                auto handleRequest = [&lengths](std::pmr::memory_resource* resource)
+                {
+                    std::pmr::vector<BufferClass::MyBuffer<>> live(resource);
+                    live.reserve(lengths.size());
+
+                    for (const unsigned int length : lengths)
+                    {
+                        live.emplace_back(length); // The vector passes its resource on to the buffer
+                        live.back().Fill(static_cast<int>(length));
+
+                        if (live.size() % 4 == 0)
+                        {
+                            live.pop_back(); // Some buffers die young
+                        }
+                    }
+                };
+
+                double heapTime = 0.0;
+                double monotonicTime = 0.0;
+                double poolTime = 0.0;
+                {
+                    heapTime = Benchmark::MeasureMicroseconds([&handleRequest]()
+                    {
+                        handleRequest(std::pmr::new_delete_resource());
+                    }, requests);
+
+                    std::vector<std::byte> arenaStorage(8 * 1024 * 1024);
+                    monotonicTime = Benchmark::MeasureMicroseconds([&handleRequest, &arenaStorage]()
+                    {
+                        // One arena per request, every buffer is released at once when it goes out of scope
+                        std::pmr::monotonic_buffer_resource arena(arenaStorage.data(), arenaStorage.size());
+                        handleRequest(&arena);
+                    }, requests);
+
+                    std::pmr::unsynchronized_pool_resource requestPool;
+                    poolTime = Benchmark::MeasureMicroseconds([&handleRequest, &requestPool]()
+                    {
+                        handleRequest(&requestPool);
+                    }, requests);
+                }
+
+                cout << "Request with the default heap: " << heapTime << " us" << endl;
+                cout << "Request with monotonic_buffer_resource: " << monotonicTime << " us" << endl;
+                cout << "Request with unsynchronized_pool_resource: " << poolTime << " us" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Recycling buffers through a thread-caching pool
+            {
+                /*
+                 * - A service that creates and drops buffers of the same few sizes millions of times pays the general
+                 *   purpose allocator every time, even though the block it just freed would fit the next request.
+                 * - BufferClass::BufferPool keeps freed blocks instead, sorted in power-of-two size classes (64 bytes
+                 *   up to 1 MB). A 300-int buffer needs 1200 bytes and gets a 2048-byte block.
+                 * - Every thread has its own free list per class, so recycling needs no lock. Lists longer than
+                 *   PoolSettings::threadCacheBlocks give half of their blocks to a global pool, and an empty list takes
+                 *   a batch from it: a thread that only frees does not hoard memory another thread is asking for.
+                 * - The global pool frees blocks back to the heap once it retains more than
+                 *   PoolSettings::globalRetainedBytes. Trim() empties it on demand.
+                 *
+                 * - Pooling is opt-in: MyBuffer(BufferClass::pooled, length). The pool is an std::pmr::memory_resource,
+                 *   so the copy and move rules of the previous block apply unchanged.
+                 */
+
+                cout << "Recycling buffers through a thread-caching pool!" << endl;
+
+                BufferClass::BufferPool& bufferPool = BufferClass::BufferPool::Instance();
+                const BufferClass::PoolStats before = bufferPool.Stats();
+
+                constexpr std::array<unsigned int, 3> recurringLengths{300, 1024, 4000};
+                constexpr int requestCount = 200000;
+
+                auto serveRequests = [&recurringLengths](const bool usePool)
+                {
+                    long long checksum = 0;
+                    for (int request = 0; request < requestCount; ++request)
+                    {
+                        const unsigned int length = recurringLengths[request % recurringLengths.size()];
+                        BufferClass::MyBuffer scratch = usePool ? BufferClass::MyBuffer(BufferClass::pooled, length)
+                                                                : BufferClass::MyBuffer(length);
+                        scratch[0] = request;
+                        checksum += scratch[0];
+                    }
+                    return checksum;
+                };
+
+                const double heapTime = Benchmark::MeasureMicroseconds([&serveRequests]() { serveRequests(false); }, 1);
+                const double poolTime = Benchmark::MeasureMicroseconds([&serveRequests]() { serveRequests(true); }, 1);
+
+                // Two threads exchanging pooled buffers: one frees what the other allocated
+                std::vector<BufferClass::MyBuffer<>> handOff;
+                std::thread producer([&handOff]()
+                {
+                    for (int i = 0; i < 1000; ++i)
+                    {
+                        handOff.emplace_back(BufferClass::pooled, 512);
+                    }
+                });
+                producer.join();
+                handOff.clear(); // Freed on this thread, the blocks end up in this thread's cache and the global pool
+
+                const BufferClass::PoolStats after = bufferPool.Stats();
+                const std::uint64_t requests = after.requests - before.requests;
+                const std::uint64_t hits = after.hits - before.hits;
+
+                cout << requestCount << " requests with the default heap: " << heapTime << " us" << endl;
+                cout << requestCount << " requests with the buffer pool: " << poolTime << " us" << endl;
+                cout << "Pool hit rate: " << (requests == 0 ? 0.0 : 100.0 * hits / requests) << "%, retained: "
+                    << after.retainedBytes << " bytes" << endl;
+
+                bufferPool.Trim();
+                cout << "Retained after Trim (thread caches only): " << bufferPool.Stats().retainedBytes << " bytes"
+                    << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Memory-mapped buffers
+            {
+                /*
+                 * - Loading a large file into a buffer normally means reading it into the heap element by element.
+                 * - mmap asks the operating system to make the file itself appear in memory. Nothing is read up front:
+                 *   the first access to each page loads it, and pages that are never touched are never loaded. The page
+                 *   cache is shared, so mapping the same file twice does not use twice the memory.
+                 *
+                 * - MyBuffer(BufferClass::mappedFile, path, mode) or MyBuffer::MapFile(path, mode) map a file of raw
+                 *   ints. mNumbers simply points into the mapping, so operator[], SetValue and DisplayBuffer work
+                 *   unchanged. Copying a mapped buffer produces an ordinary heap buffer.
+                 * - Advise(AccessPattern) passes madvise hints, Flush/Sync write a ReadWrite mapping back to disk.
+                 * - MyBuffer(mappedFile, path, mode, byteOffset, length) maps only part of a file, such as the payload
+                 *   behind a header (see BufferFile below).
+                 */
+
+                cout << "Memory-mapped buffers!" << endl;
+
+                const std::filesystem::path filePath = std::filesystem::temp_directory_path() / "mybuffer_mapped.bin";
+                {
+                    std::ofstream file(filePath, std::ios::binary);
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        file.write(reinterpret_cast<const char*>(&i), sizeof(i));
+                    }
+                }
+
+                const std::string fileName = filePath.string();
+                if (auto readOnly = BufferClass::MyBuffer<>::MapFile(fileName.c_str()))
+                {
+                    readOnly->Advise(BufferClass::AccessPattern::Sequential);
+                    cout << "Read-only mapping: ";
+                    readOnly->DisplayBuffer();
+
+                    BufferClass::MyBuffer privateCopy(BufferClass::mappedFile, fileName.c_str(),
+                                                      BufferClass::MapMode::CopyOnWrite);
+                    privateCopy[0] = 100; // Only this process sees the change
+                    cout << "Copy-on-write mapping after writing 100: ";
+                    privateCopy.DisplayBuffer();
+
+                    BufferClass::MyBuffer shared(BufferClass::mappedFile, fileName.c_str(),
+                                                 BufferClass::MapMode::ReadWrite);
+                    shared.SetValue(7, 700);
+                    shared.Sync();
+                    cout << "Read-only mapping after a ReadWrite mapping wrote 700 and synced: ";
+                    readOnly->DisplayBuffer(); // Same file, same pages
+                }
+                else
+                {
+                    cout << "Memory mapping is not available on this platform." << endl;
+                }
+
+                std::filesystem::remove(filePath);
+            }
+            cout << "\n\n" << endl;
+
+            // Binary files: save once, map back without parsing
+            {
+                /*
+                 * - Printing a buffer and reading it back means formatting every number as text and parsing it again.
+                 * - BufferFile stores the bytes themselves. Every record is a 32 byte Header (magic "MYBF", format
+                 *   version, element type, length and a checksum of the payload) followed by the raw little-endian
+                 *   elements.
+                 * - Writer::Append sends padding, header and payload to the file with one writev call, directly from the
+                 *   buffer's memory: no staging copy. Many buffers of different element types can go into one file;
+                 *   Finish writes an index footer with the offset of every record.
+                 * - Reader finds the footer and Load<T>(i) maps the payload of record i into a MyBuffer<T> with the
+                 *   offset constructor of the mapped buffers. Loading is an mmap, not a parse step.
+                 * - A file whose writer died before Finish has no footer; Reader then walks the headers and keeps every
+                 *   complete record.
+                 */
+
+                cout << "Binary files: save once, map back without parsing!" << endl;
+
+                const std::filesystem::path filePath = std::filesystem::temp_directory_path() / "mybuffer_records.bin";
+                const std::string fileName = filePath.string();
+
+                BufferClass::MyBuffer<> counts(6);
+                BufferClass::MyBuffer<double> ratios(3);
+                for (unsigned int i = 0; i < counts.GetLength(); ++i)
+                {
+                    counts[i] = static_cast<int>(i * i);
+                }
+                for (unsigned int i = 0; i < ratios.GetLength(); ++i)
+                {
+                    ratios[i] = 1.0 / (i + 2);
+                }
+
+                {
+                    BufferFile::Writer writer(fileName.c_str());
+                    writer.Append(counts);
+                    writer.Append(ratios);
+                    writer.Append(counts.Slice(2, 3));
+                    cout << "Records written: " << writer.GetCount() << ", file complete: " << std::boolalpha
+                        << writer.Finish() << std::noboolalpha << endl;
+                }
+
+                const BufferFile::Reader reader(fileName.c_str());
+                cout << "Records in the index: " << reader.GetCount() << endl;
+
+                if (auto loadedRatios = reader.Load<double>(1))
+                {
+                    cout << "Record 1 mapped as doubles: ";
+                    loadedRatios->DisplayBuffer();
+                }
+                if (auto loadedSlice = reader.Load<int>(2))
+                {
+                    cout << "Record 2 mapped as ints: ";
+                    loadedSlice->DisplayBuffer();
+                }
+                cout << "Record 1 requested as ints: " << (reader.Load<int>(1) ? "loaded" : "refused") << endl;
+
+                // Save and Load handle the common case of one buffer per file
+                constexpr unsigned int length = 1'000'000;
+                BufferClass::MyBuffer<> large(length);
+                for (unsigned int i = 0; i < length; ++i)
+                {
+                    large[i] = static_cast<int>(i * 7u % 1000u);
+                }
+
+                long long checksum = 0;
+                const double binaryTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    BufferFile::Save(large, fileName.c_str());
+                    if (auto loaded = BufferFile::Load<int>(fileName.c_str()))
+                    {
+                        checksum += loaded->Sum();
+                    }
+                }, 1);
+                const double textTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    {
+                        std::ofstream text(filePath);
+                        for (unsigned int i = 0; i < length; ++i)
+                        {
+                            text << large[i] << '\n';
+                        }
+                    }
+
+                    std::ifstream text(filePath);
+                    BufferClass::MyBuffer<> parsed(length);
+                    for (unsigned int i = 0; i < length && text >> parsed[i]; ++i)
+                    {
+                    }
+                    checksum -= parsed.Sum();
+                }, 1);
+
+                cout << "Save and reload a million ints, binary: " << binaryTime << " us, as text: " << textTime
+                    << " us (checksum difference " << checksum << ")" << endl;
+
+                std::filesystem::remove(filePath);
+            }
+            cout << "\n\n" << endl;
+
+            // Checksums and hashes
+            {
+                /*
+                 * - Checking that a buffer survived a transfer by comparing it element by element needs both copies in
+                 *   the same place. A checksum computed on each side only needs the two numbers compared.
+                 * - Crc32c() computes CRC-32C with the crc32 instruction of SSE4.2: eight bytes per instruction. CPUs
+                 *   without it use slicing-by-8, eight table lookups per eight bytes that do not wait on each other.
+                 * - Hash64(seed) is XXH64, a fast non-cryptographic 64-bit hash: good for hash tables, deduplication
+                 *   and detecting changes, useless against an attacker.
+                 * - Crc32cHasher and Hasher64 take the data in pieces: feed them slices or chunks in order and Finish
+                 *   returns the same value as hashing everything at once.
+                 * - BufferFile stores the CRC-32C of every payload in its record header (format version 2) and checks
+                 *   it when a record is loaded.
+                 */
+
+                cout << "Checksums and hashes!" << endl;
+
+                BufferClass::MyBuffer<> received(1000);
+                for (unsigned int i = 0; i < received.GetLength(); ++i)
+                {
+                    received[i] = static_cast<int>(i * 31u);
+                }
+
+                BufferHash::Crc32cHasher crc;
+                BufferHash::Hasher64 hash;
+                for (unsigned int offset = 0; offset < received.GetLength(); offset += 300) // Chunks as they arrive
+                {
+                    const auto chunk = std::as_const(received).Slice(offset, 300);
+                    crc.Update(chunk.Span());
+                    hash.Update(chunk.Span());
+                }
+
+                cout << std::hex << "Crc32c: " << received.Crc32c() << ", incremental: " << crc.Finish()
+                    << ", Hash64: " << received.Hash64() << ", incremental: " << hash.Finish() << std::dec << endl;
+
+                received[500] ^= 1; // One flipped bit
+                cout << std::hex << "After flipping one bit, Crc32c: " << received.Crc32c() << ", Hash64: "
+                    << received.Hash64() << std::dec << endl;
+
+                // Throughput over 64 MiB, in bytes per cycle of the time stamp counter and in GB/s
+                constexpr unsigned int length = 16u << 20;
+                BufferClass::MyBuffer<> large(length);
+                BufferClass::MyBuffer<> copy(length);
+                std::mt19937 generator(5);
+                for (unsigned int i = 0; i < length; ++i)
+                {
+                    large[i] = static_cast<int>(generator());
+                }
+                copy = large;
+
+                constexpr double bytes = static_cast<double>(length) * sizeof(int);
+                std::uint64_t sink = 0;
+                auto measure = [&sink](const char* name, auto&& function)
+                {
+                    const std::uint64_t startCycles = Benchmark::CycleCount();
+                    const double time = Benchmark::MeasureMicroseconds([&]() { sink += function(); }, 3);
+                    const double cycles = static_cast<double>(Benchmark::CycleCount() - startCycles) / 3;
+
+                    cout << name << ": " << bytes / time / 1000.0 << " GB/s";
+                    if (cycles > 0)
+                    {
+                        cout << ", " << bytes / cycles << " bytes/cycle";
+                    }
+                    cout << endl;
+                };
+
+                measure("Element by element comparison", [&]()
+                {
+                    std::uint64_t differences = 0;
+                    for (unsigned int i = 0; i < length; ++i)
+                    {
+                        differences += large[i] != copy[i];
+                    }
+                    return differences;
+                });
+                measure("Crc32c (slicing-by-8)", [&]()
+                {
+                    return BufferHash::UpdateCrc32cSlicing(0xFFFFFFFFu, reinterpret_cast<const std::byte*>(large.Data()),
+                                                           length * sizeof(int));
+                });
+                if (BufferHash::HasCrc32Instruction())
+                {
+                    measure("Crc32c (SSE4.2)", [&]() { return large.Crc32c(); });
+                }
+                measure("Hash64 (XXH64)", [&]() { return large.Hash64(); });
+                cout << "(checksum of the results " << (sink & 0xFF) << ")" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Compressing integer buffers
+            {
+                /*
+                 * - Timestamps, ids and counters rarely need 32 bits each: sorted values differ by little from one to
+                 *   the next, and small values have many leading zero bits. BufferCodecs stores them in fewer bytes:
+                 *   - Delta: the difference with the previous value, as a zig-zag varint (7 bits per byte).
+                 *   - ZigZagVarint: the value itself as a varint; zig-zag maps -1 to 1, 1 to 2, so small negatives
+                 *     stay short too.
+                 *   - FrameOfReference: per block, the minimum once, then value - minimum in the fewest bits that
+                 *     hold the block's range.
+                 *   - BitPacked: the differences in the fewest bits, laid out in four 32-bit lanes so that SSE unpacks
+                 *     and sums four of them per instruction.
+                 * - Values are encoded in blocks of 128 that decode on their own, so At(i) only decodes the block that
+                 *   holds i (FrameOfReference does not even decode that: it reads the one value).
+                 * - Encode returns a MyBuffer<std::uint8_t>, which BufferFile saves and maps like any other buffer.
+                 */
+
+                cout << "Compressing integer buffers!" << endl;
+
+                BufferClass::MyBuffer<> timestamps(1000);
+                for (unsigned int i = 0; i < timestamps.GetLength(); ++i)
+                {
+                    timestamps[i] = 1'700'000'000 + static_cast<int>(i * 3 + i % 5);
+                }
+
+                const auto encoded = BufferCodecs::Encode(timestamps, BufferCodecs::Codec::BitPacked);
+                const BufferCodecs::EncodedView view(encoded.Span());
+                cout << "1000 timestamps: " << timestamps.GetLength() * sizeof(int) << " bytes raw, "
+                    << encoded.GetLength() << " bytes bit-packed, element 777 is " << view.At(777).value_or(-1) << endl;
+
+                const std::filesystem::path filePath = std::filesystem::temp_directory_path() / "mybuffer_encoded.bin";
+                const std::string fileName = filePath.string();
+                if (BufferFile::Save(encoded, fileName.c_str()))
+                {
+                    if (auto mapped = BufferFile::Load<std::uint8_t>(fileName.c_str()))
+                    {
+                        const auto decoded = BufferCodecs::Decode(mapped->Span());
+                        cout << "Decoded from the mapped file equals the original: " << std::boolalpha
+                            << (decoded && *decoded == timestamps) << std::noboolalpha << endl;
+                    }
+                }
+                std::filesystem::remove(filePath);
+
+                // Compression ratio and decode speed over a few typical distributions
+                constexpr unsigned int length = 1'000'000;
+                std::mt19937 generator(2024);
+                const std::array<const char*, 4> distributions{"sorted timestamps", "small ids", "signed noise",
+                                                               "uniform random"};
+                const std::array<BufferCodecs::Codec, 4> codecs{BufferCodecs::Codec::Delta,
+                                                                BufferCodecs::Codec::ZigZagVarint,
+                                                                BufferCodecs::Codec::FrameOfReference,
+                                                                BufferCodecs::Codec::BitPacked};
+                const std::array<const char*, 4> codecNames{"Delta", "ZigZagVarint", "FrameOfReference", "BitPacked"};
+
+                BufferClass::MyBuffer<> values(length);
+                BufferClass::MyBuffer<> decoded(length);
+                for (std::size_t d = 0; d < distributions.size(); ++d)
+                {
+                    // Seconds in 2001 onwards. Even a million steps of the largest gap, 999, stay below INT_MAX.
+                    int previous = 1'000'000'000;
+                    static_assert(1'000'000'000LL + 999LL * length <= std::numeric_limits<int>::max());
+                    for (unsigned int i = 0; i < length; ++i)
+                    {
+                        switch (d)
+                        {
+                            case 0: previous += static_cast<int>(generator() % 1000); values[i] = previous; break;
+                            case 1: values[i] = static_cast<int>(generator() % 1024); break;
+                            case 2: values[i] = static_cast<int>(generator() % 101) - 50; break;
+                            default: values[i] = static_cast<int>(generator()); break;
+                        }
+                    }
+
+                    cout << distributions[d] << ":" << endl;
+                    for (std::size_t c = 0; c < codecs.size(); ++c)
+                    {
+                        const auto bytes = BufferCodecs::Encode(values, codecs[c]);
+                        const BufferCodecs::EncodedView encodedValues(bytes.Span());
+                        const double decodeTime = Benchmark::MeasureMicroseconds([&]()
+                        {
+                            encodedValues.DecodeTo(decoded.Data());
+                        }, 5);
+
+                        cout << "  " << codecNames[c] << ": ratio " << static_cast<double>(length * sizeof(int)) /
+                            bytes.GetLength() << ", decodes " << length / decodeTime << " M ints/s, round trip "
+                            << (decoded == values ? "ok" : "FAILED") << endl;
+                    }
+                }
+            }
+            cout << "\n\n" << endl;
+
+            // Segmented (rope) buffers for append-heavy work
+            {
+                /*
+                 * - A MyBuffer is one contiguous block. Appending one more element with Concatenate or operator+ means
+                 *   allocating a bigger block and copying everything into it, so accumulating n samples costs O(n^2)
+                 *   copies. PushBack brings that down to amortized O(1), but every reallocation still moves all the
+                 *   elements stored so far, and a large buffer needs one large contiguous block.
+                 * - BufferRope keeps a list of MyBuffer chunks instead:
+                 *   - Append(int) writes into the free space of the last chunk and starts a new 4096-int chunk when it
+                 *     is full, O(1) amortized.
+                 *   - Append(MyBuffer&&) and Append(BufferRope&&) adopt whole chunks without copying their elements.
+                 *   - rope[i] finds its chunk with a binary search over the chunk start offsets.
+                 *   - Iterating walks each chunk with a plain pointer, so memory is read sequentially.
+                 *   - Flatten() produces a contiguous MyBuffer once the accumulation is done.
+                 */
+
+                cout << "Segmented rope buffer!" << endl;
+
+                BufferClass::BufferRope samples;
+                for (int i = 0; i < 10; ++i)
+                {
+                    samples.Append(i);
+                }
+
+                BufferClass::MyBuffer burst(3);
+                burst.Fill(42);
+                samples.Append(burst);
+
+                long long total = 0;
+                for (const int sample : samples)
+                {
+                    total += sample;
+                }
+
+                cout << "Rope with " << samples.GetLength() << " samples in " << samples.ChunkCount()
+                    << " chunk(s), sum: " << total << ", samples[11]: " << samples[11] << endl;
+
+                BufferClass::MyBuffer flat = samples.Flatten();
+                cout << "Flattened: ";
+                flat.DisplayBuffer();
+
+                // Timing: accumulate samples one by one, rope against re-concatenating a contiguous buffer
+                constexpr int sampleCount = 10000;
+                double ropeTime = 0.0;
+                double concatenateTime = 0.0;
+                {
+                    ropeTime = Benchmark::MeasureMicroseconds([]()
+                    {
+                        BufferClass::BufferRope log;
+                        for (int i = 0; i < sampleCount; ++i)
+                        {
+                            log.Append(i);
+                        }
+                    }, 1);
+
+                    concatenateTime = Benchmark::MeasureMicroseconds([]()
+                    {
+                        BufferClass::MyBuffer log(0);
+                        BufferClass::MyBuffer sample(1);
+                        for (int i = 0; i < sampleCount; ++i)
+                        {
+                            sample[0] = i;
+                            log = log.Concatenate(sample);
+                        }
+                    }, 1);
+                }
+
+                cout << sampleCount << " appends to a rope: " << ropeTime << " us" << endl;
+                cout << sampleCount << " appends through Concatenate: " << concatenateTime << " us" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Parallel reductions and transforms
+            {
+                /*
+                 * - Sum, Min, Max, MinMax, Count(value), Transform(function) and InclusiveScan save everybody from
+                 *   writing the same loops over operator[].
+                 * - Below BufferParallel::Config().threshold elements they run on the calling thread with the SIMD
+                 *   kernels: starting threads costs more than it saves on short buffers.
+                 * - Above it the buffer is cut in chunks that run in parallel. Reductions combine one partial result
+                 *   per chunk. InclusiveScan needs two passes: every chunk is scanned on its own, then each chunk adds
+                 *   the total of the chunks before it.
+                 * - With MYBUFFER_USE_STD_EXECUTION (CMake sets it when TBB is available) the chunks are scheduled with
+                 *   the C++17 parallel algorithms. Otherwise, or when Config().threads asks for an exact thread count,
+                 *   they run on an internal fork-join pool.
+                 */
+
+                cout << "Parallel reductions and transforms!" << endl;
+
+                BufferClass::MyBuffer samples(10);
+                for (unsigned int i = 0; i < samples.GetLength(); ++i)
+                {
+                    samples[i] = static_cast<int>(i % 4) - 1;
+                }
+
+                const auto [minimum, maximum] = samples.MinMax();
+                cout << "Sum: " << samples.Sum() << ", Min: " << minimum << ", Max: " << maximum << ", Count(2): "
+                    << samples.Count(2) << endl;
+
+                samples.Transform([](const int value) { return value * 10; });
+                samples.InclusiveScan();
+                cout << "After Transform(x * 10) and InclusiveScan: ";
+                samples.DisplayBuffer();
+
+                // Scaling benchmark: 1 to N threads over growing buffers. The largest size is 10^7 so the lesson runs
+                // anywhere, raise it to 1'000'000'000 (4 GB of ints) on a machine that has the memory.
+                constexpr unsigned int largestSize = 10'000'000;
+                const BufferParallel::Settings defaults = BufferParallel::Config();
+                const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+                BufferParallel::Config().threshold = 1;
+                int wrongSums = 0;
+
+                for (unsigned int size = 1'000'000; size <= largestSize; size *= 10)
+                {
+                    BufferClass::MyBuffer buffer(size);
+                    buffer.Fill(1);
+
+                    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+                    {
+                        BufferParallel::Config().threads = threads;
+                        long long checksum = 0;
+                        const double sumTime = Benchmark::MeasureMicroseconds([&]() { checksum += buffer.Sum(); }, 5);
+                        const double scanTime = Benchmark::MeasureMicroseconds([&]()
+                        {
+                            buffer.Fill(1);
+                            buffer.InclusiveScan();
+                        }, 5);
+
+                        cout << size << " elements, " << threads << " thread(s): Sum " << sumTime << " us, Fill + "
+                            << "InclusiveScan " << scanTime << " us" << endl;
+                        wrongSums += checksum != 5LL * size;
+                    }
+                }
+
+                cout << "Parallel sums that missed the expected total: " << wrongSums << endl;
+
+                BufferParallel::Config() = defaults;
+            }
+            cout << "\n\n" << endl;
+
+            // One buffer template for every element type
+            {
+                /*
+                 * - MyBuffer is a class template: MyBuffer<T, Allocator>. T defaults to int and Allocator to the pmr
+                 *   allocator, so BufferClass::MyBuffer buffer(5) still declares the int buffer used everywhere above.
+                 *   Where a type is required (std::vector<MyBuffer<>>, MyBuffer<>::kInlineCapacity) write MyBuffer<>.
+                 * - Trivially copyable element types (int, double, std::uint64_t, plain structs) are copied with
+                 *   memcpy, and int keeps the SIMD kernels of BufferKernels.
+                 * - Moving elements to new storage (an inline buffer, or a buffer on another memory resource) is a
+                 *   memcpy as well for "trivially relocatable" types. Specialize BufferClass::isTriviallyRelocatable
+                 *   for types that only own a pointer to get the same treatment.
+                 * - Anything else, std::string for example, is constructed, copied, moved and destroyed element by
+                 *   element, exactly like a std::vector would.
+                 * - Sum, MinMax, InclusiveScan and friends exist for arithmetic types only, the comparison operators
+                 *   for types that can be compared.
+                 */
+
+                cout << "One buffer template for every element type!" << endl;
+
+                BufferClass::MyBuffer<double> readings(4);
+                readings.Fill(0.25);
+                readings.InclusiveScan();
+                cout << "Doubles after InclusiveScan: ";
+                readings.DisplayBuffer();
+
+                BufferClass::MyBuffer<std::string> words(2);
+                words[0] = "Hello";
+                words[1] = "buffers!";
+                BufferClass::MyBuffer<std::string> twice(words + words); // Copy-constructs four strings, nothing more
+                cout << "Strings concatenated: ";
+                twice.DisplayBuffer();
+            }
+            cout << "\n\n" << endl;
+
+            // Growable buffers: capacity and growth policies
+            {
+                /*
+                 * - Like the std::vector of DynamicArrays.cpp, MyBuffer now separates its length (GetLength) from its
+                 *   capacity (GetCapacity): PushBack writes into spare room and only reallocates once it runs out.
+                 * - Reserve(n) makes room for n elements up front, Resize(n) adds or drops elements, ShrinkToFit()
+                 *   gives the spare room back.
+                 * - SetGrowthPolicy chooses how much room a reallocation adds:
+                 *   - GrowthPolicy::Factor(2.0): the default. Few reallocations, up to half of the memory unused.
+                 *   - GrowthPolicy::Factor(1.5): more reallocations, less waste.
+                 *   - GrowthPolicy::Step(n): n more elements each time. Cheap on memory, but the number of
+                 *     reallocations grows with the length, and so do the bytes moved.
+                 * - Past GrowthPolicy::remapBytes (1 MB by default) a trivially copyable buffer moves to an anonymous
+                 *   memory mapping. From then on mremap resizes the mapping: the kernel extends it in place or moves
+                 *   its pages around, without copying a single element (Linux only).
+                 * - MyBuffer<T>::GrowthTelemetry() counts reallocations, bytes moved and remaps per element type.
+                 */
+
+                cout << "Growable buffers!" << endl;
+
+                BufferClass::MyBuffer growing(0);
+                for (int i = 0; i < 100; ++i)
+                {
+                    const unsigned int capacityBefore = growing.GetCapacity();
+                    growing.PushBack(i);
+                    if (growing.GetCapacity() != capacityBefore)
+                    {
+                        cout << "Length " << growing.GetLength() << ", capacity grows to " << growing.GetCapacity()
+                            << endl;
+                    }
+                }
+
+                growing.Resize(5);
+                growing.ShrinkToFit();
+                cout << "After Resize(5) and ShrinkToFit, capacity: " << growing.GetCapacity() << ", on the heap: "
+                    << growing.IsOnHeap() << endl;
+
+                // Compare the policies: 4 million pushes, once with mremap and once without it
+                constexpr unsigned int pushes = 4'000'000;
+                struct NamedPolicy
+                {
+                    const char* name;
+                    BufferClass::GrowthPolicy policy;
+                };
+
+                const NamedPolicy policies[] = {{"Factor 2", BufferClass::GrowthPolicy::Factor(2.0)},
+                                                {"Factor 1.5", BufferClass::GrowthPolicy::Factor(1.5)},
+                                                {"Step 65536", BufferClass::GrowthPolicy::Step(65536)}};
+
+                for (const std::size_t remapBytes : {std::size_t{0}, std::size_t{1} << 20})
+                {
+                    for (const NamedPolicy& named : policies)
+                    {
+                        BufferClass::GrowthPolicy policy = named.policy;
+                        policy.remapBytes = remapBytes;
+                        BufferClass::MyBuffer<>::ResetGrowthTelemetry();
+
+                        const double pushTime = Benchmark::MeasureMicroseconds([&policy]()
+                        {
+                            BufferClass::MyBuffer samples(0);
+                            samples.SetGrowthPolicy(policy);
+                            for (unsigned int i = 0; i < pushes; ++i)
+                            {
+                                samples.PushBack(static_cast<int>(i));
+                            }
+                        }, 1);
+
+                        const BufferClass::GrowthStats stats = BufferClass::MyBuffer<>::GrowthTelemetry();
+                        cout << named.name << (remapBytes != 0 ? " with mremap: " : ": ") << pushTime << " us, "
+                            << stats.reallocations << " reallocations, " << stats.bytesMoved / (1024 * 1024)
+                            << " MB moved, " << stats.remaps << " remaps" << endl;
+                    }
+                }
+            }
+            cout << "\n\n" << endl;
+
+            // Slices: views that copy nothing
+            {
+                /*
+                 * - Passing part of a buffer used to mean copying it into a new MyBuffer first.
+                 * - buffer.Slice(offset, length) returns a BufferView instead: a pointer and a length into the buffer's
+                 *   own elements. It is as cheap to pass by value as a std::span, and converts to one, so functions
+                 *   written for std::span<const int> accept slices directly.
+                 * - Slicing a const buffer gives a BufferView<const int>, which cannot write to the elements.
+                 * - Views have the read operations of MyBuffer (operator[], DisplayBuffer, ==, <=>, Sum, MinMax, Count)
+                 *   and take part in lazy concatenation: a.Slice(0, 4) + b.Slice(2, 3) copies each source once, straight
+                 *   into the result.
+                 * - A view does not own anything. Once its buffer is destroyed, moved from or reallocated, the view
+                 *   dangles. Builds without NDEBUG keep track of that and assert on the first use of a dangling view.
+                 */
+
+                cout << "Slices: views that copy nothing!" << endl;
+
+                BufferClass::MyBuffer readings(12);
+                for (unsigned int i = 0; i < readings.GetLength(); ++i)
+                {
+                    readings[i] = static_cast<int>(i * i);
+                }
+
+                auto average = [](const std::span<const int> window)
+                {
+                    return window.empty() ? 0.0 : std::accumulate(window.begin(), window.end(), 0.0) / window.size();
+                };
+
+                const auto morning = std::as_const(readings).Slice(0, 6);
+                const auto evening = std::as_const(readings).Slice(6, 6);
+                cout << "Morning average: " << average(morning) << ", evening max: " << evening.Max() << endl;
+
+                BufferClass::MyBuffer edges(readings.Slice(0, 2) + readings.Slice(10, 2)); // 4 elements, copied once
+                cout << "First and last two readings: ";
+                edges.DisplayBuffer();
+
+                // Benchmark: hand the middle half of a buffer to a function, as a copy and as a slice
+                BufferClass::MyBuffer large(1 << 20);
+                large.Fill(1);
+                constexpr int repetitions = 100;
+                long long checksum = 0;
+
+                const double copyTime = Benchmark::MeasureMicroseconds([&large, &checksum]()
+                {
+                    BufferClass::MyBuffer middle(large.GetLength() / 2);
+                    BufferKernels::Copy(middle.Data(), large.Data() + large.GetLength() / 4, middle.GetLength());
+                    checksum += middle[0];
+                }, repetitions);
+
+                const double sliceTime = Benchmark::MeasureMicroseconds([&large, &checksum]()
+                {
+                    const auto middle = std::as_const(large).Slice(large.GetLength() / 4, large.GetLength() / 2);
+                    checksum += middle[0];
+                }, repetitions);
+
+                cout << "Passing half a million ints as a copy: " << copyTime << " us, as a slice: " << sliceTime
+                    << " us (checksum " << checksum << ")" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Sorting buffers in place
+            {
+                /*
+                 * - Sorting a MyBuffer used to mean copying it into a std::vector, calling std::sort and copying back.
+                 *   Sort, StableSort and ArgSort now work on the buffer itself:
+                 *   - Under 32 elements a sorting network: a fixed sequence of compare-exchanges (min and max, no
+                 *     branches to mispredict).
+                 *   - 32- and 64-bit integers in the default order use LSD radix sort: one pass counts the bytes of
+                 *     every key, then one pass per byte scatters the keys by that byte. O(n) instead of O(n log n),
+                 *     and bytes that are equal in every key are skipped. Radix sort is stable by nature.
+                 *   - Other types and custom comparisons use std::sort and std::stable_sort.
+                 *   - Past BufferParallel::Config().threshold elements every thread sorts one chunk, then sorted runs
+                 *     are merged two by two. Each merge is split across the threads by output position with a binary
+                 *     search (the merge path), so even the final merge of two halves uses every thread.
+                 * - ArgSort leaves the buffer alone and returns the indices that would sort it, ties in order.
+                 */
+
+                cout << "Sorting buffers in place!" << endl;
+
+                BufferClass::MyBuffer<> scores(8);
+                const std::array<int, 8> initialScores{42, -7, 13, 42, 0, 99, -7, 5};
+                std::copy(initialScores.begin(), initialScores.end(), scores.Data());
+
+                const auto ranking = scores.ArgSort();
+                cout << "ArgSort: ";
+                ranking.DisplayBuffer();
+                scores.Sort();
+                cout << "Sort: ";
+                scores.DisplayBuffer();
+                scores.StableSort(std::greater<>{});
+                cout << "StableSort(std::greater<>): ";
+                scores.DisplayBuffer();
+
+                // Benchmark against copying into a std::vector and std::sort, over four typical inputs
+                constexpr unsigned int length = 2'000'000;
+                std::mt19937 generator(17);
+                const std::array<const char*, 4> inputs{"uniform", "sorted", "reverse", "few unique"};
+                BufferClass::MyBuffer<> original(length);
+                BufferClass::MyBuffer<> work(length);
+
+                for (std::size_t input = 0; input < inputs.size(); ++input)
+                {
+                    for (unsigned int i = 0; i < length; ++i)
+                    {
+                        switch (input)
+                        {
+                            case 0: original[i] = static_cast<int>(generator()); break;
+                            case 1: original[i] = static_cast<int>(i); break;
+                            case 2: original[i] = static_cast<int>(length - i); break;
+                            default: original[i] = static_cast<int>(generator() % 16); break;
+                        }
+                    }
+
+                    const double stdTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        std::vector<int> copy(original.Data(), original.Data() + length);
+                        std::sort(copy.begin(), copy.end());
+                        std::copy(copy.begin(), copy.end(), work.Data());
+                    }, 3);
+                    const bool sameAsStd = std::is_sorted(work.Data(), work.Data() + length);
+
+                    const double sortTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        work = original;
+                        work.Sort();
+                    }, 3);
+
+                    cout << inputs[input] << ": vector + std::sort " << stdTime << " us, MyBuffer::Sort " << sortTime
+                        << " us (" << (sameAsStd && std::is_sorted(work.Data(), work.Data() + length) ? "sorted" :
+                                       "NOT sorted") << ")" << endl;
+                }
+            }
+            cout << "\n\n" << endl;
+
+            // Searching buffers
+            {
+                /*
+                 * - Find, FindIf and CountIf test a whole SIMD register of elements per instruction for the simple
+                 *   predicates of BufferKernels::Predicate: Equal, Less, Greater and Between (low <= x <= high).
+                 *   - The comparison produces a mask of all-ones lanes, movemask turns it into one bit per element,
+                 *     and countr_zero of the bits is the position of the first match. FindIf tests 16 (SSE) or 32
+                 *     (AVX2) elements before it branches once.
+                 *   - CountIf subtracts the masks from a register of counters: all ones is -1, so every lane counts
+                 *     its own matches without a branch.
+                 *   - Any other callable goes through FindIf(function), one element at a time.
+                 * - LowerBound on a sorted buffer is a branchless binary search: the comparison picks the half with a
+                 *   conditional move instead of a jump the processor would mispredict half of the time.
+                 * - EytzingerIndex stores the keys as a breadth-first tree (children of k at 2k and 2k + 1). The
+                 *   search path walks down memory in one direction, which lets a prefetch fetch the nodes four levels
+                 *   ahead: for large arrays this beats even the branchless binary search, at the cost of a copy.
+                 */
+
+                cout << "Searching buffers!" << endl;
+
+                BufferClass::MyBuffer<> readings(10);
+                const std::array<int, 10> initialReadings{12, 18, 25, 31, 7, 44, 25, 3, 19, 50};
+                std::copy(initialReadings.begin(), initialReadings.end(), readings.Data());
+
+                using IntPredicate = BufferKernels::Predicate<int>;
+                cout << "Find(25): " << readings.Find(25) << ", Find(99): " << readings.Find(99)
+                    << " (not found is GetLength())" << endl;
+                cout << "First reading above 40: " << readings.FindIf(IntPredicate::Greater(40))
+                    << ", readings between 10 and 30: " << readings.CountIf(IntPredicate::Between(10, 30))
+                    << ", first odd reading: " << readings.FindIf([](const int value) { return value % 2 != 0; })
+                    << endl;
+
+                readings.Sort();
+                const BufferClass::EytzingerIndex<int> readingIndex(readings);
+                cout << "Sorted: ";
+                readings.DisplayBuffer();
+                cout << "LowerBound(25): " << readings.LowerBound(25) << ", EytzingerIndex: "
+                    << readingIndex.LowerBound(25) << ", LowerBound(51): " << readings.LowerBound(51) << endl;
+
+                // Every kernel level finds the same positions as std::find_if and counts like std::count_if
+                constexpr unsigned int length = 1 << 22;
+                std::mt19937 generator(23);
+                BufferClass::MyBuffer<> values(length);
+                for (unsigned int i = 0; i < length; ++i)
+                {
+                    values[i] = static_cast<int>(generator() % 1'000'000);
+                }
+
+                const std::array<IntPredicate, 4> predicates{IntPredicate::Equal(values[length - 5]),
+                                                             IntPredicate::Less(3), IntPredicate::Greater(999'990),
+                                                             IntPredicate::Between(500'000, 500'010)};
+                const BufferKernels::KernelLevel activeLevel = BufferKernels::ActiveTable()->level;
+                for (const BufferKernels::KernelLevel level : {BufferKernels::KernelLevel::Scalar,
+                                                               BufferKernels::KernelLevel::SSE,
+                                                               BufferKernels::KernelLevel::AVX2})
+                {
+                    if (!BufferKernels::SetLevel(level))
+                    {
+                        continue;
+                    }
+
+                    unsigned int mismatches = 0;
+                    for (const IntPredicate& predicate : predicates)
+                    {
+                        for (const unsigned int offset : {0u, 1u, 3u, 17u})
+                        {
+                            const auto view = values.Slice(offset, length - 2 * offset);
+                            const auto expected = std::find_if(view.begin(), view.end(), predicate) - view.begin();
+                            mismatches += view.FindIf(predicate) != static_cast<unsigned int>(expected);
+                            mismatches += view.CountIf(predicate) !=
+                                static_cast<std::size_t>(std::count_if(view.begin(), view.end(), predicate));
+                        }
+                    }
+
+                    cout << BufferKernels::ActiveTable()->name << " searches against std::find_if and std::count_if: "
+                        << mismatches << " mismatches" << endl;
+                }
+                BufferKernels::SetLevel(activeLevel);
+
+                // Benchmarks: a value near the end, and a million lookups in a sorted buffer far larger than the cache
+                const int needle = values[length - 5];
+                std::size_t checksum = 0;
+                const double stdFindTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    checksum += static_cast<std::size_t>(std::find(values.Data(), values.Data() + length, needle) -
+                                                         values.Data());
+                }, 20);
+                const double findTime = Benchmark::MeasureMicroseconds([&]() { checksum += values.Find(needle); }, 20);
+                cout << "Find in " << length << " ints, std::find: " << stdFindTime << " us, MyBuffer::Find ("
+                    << BufferKernels::ActiveTable()->name << "): " << findTime << " us" << endl;
+
+                values.Sort();
+                const BufferClass::EytzingerIndex<int> index(values);
+                std::vector<int> queries(1'000'000);
+                for (int& query : queries)
+                {
+                    query = static_cast<int>(generator() % 1'000'000);
+                }
+
+                unsigned int disagreements = 0;
+                for (std::size_t i = 0; i < 1000; ++i)
+                {
+                    const auto expected = std::lower_bound(values.Data(), values.Data() + length, queries[i]) -
+                        values.Data();
+                    disagreements += values.LowerBound(queries[i]) != static_cast<unsigned int>(expected);
+                    disagreements += index.LowerBound(queries[i]) != static_cast<unsigned int>(expected);
+                }
+
+                const double stdLowerBoundTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    for (const int query : queries)
+                    {
+                        checksum += static_cast<std::size_t>(std::lower_bound(values.Data(), values.Data() + length,
+                                                                              query) - values.Data());
+                    }
+                }, 1);
+                const double lowerBoundTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    for (const int query : queries)
+                    {
+                        checksum += values.LowerBound(query);
+                    }
+                }, 1);
+                const double eytzingerTime = Benchmark::MeasureMicroseconds([&]()
+                {
+                    for (const int query : queries)
+                    {
+                        checksum += index.LowerBound(query);
+                    }
+                }, 1);
+                cout << "A million lookups, std::lower_bound: " << stdLowerBoundTime << " us, MyBuffer::LowerBound: "
+                    << lowerBoundTime << " us, EytzingerIndex: " << eytzingerTime << " us (" << disagreements
+                    << " disagreements, checksum " << checksum % 1000 << ")" << endl;
+            }
+            cout << "\n\n" << endl;
+
+            // Lock-free ring buffers between threads
+            {
+                /*
+                 * - Handing samples from a producer thread to a consumer thread through a MyBuffer guarded by a mutex
+                 *   works, but every push and every pop takes the lock, and a thread that finds it taken may be put
+                 *   to sleep by the operating system.
+                 * - SpscRingBuffer<T> is for exactly one producer and one consumer. The producer only writes the tail,
+                 *   the consumer only writes the head, each on its own cache line. A release store of the tail
+                 *   publishes the values written before it; the acquire load on the other side sees them.
+                 * - MpmcRingBuffer<T> accepts any number of producers and consumers. Each slot has a sequence number
+                 *   telling whose turn it is, positions are claimed with a compare-and-swap.
+                 * - Both keep the values in a MyBuffer<T> of power-of-two capacity and have batch versions of push and
+                 *   pop: PushBatch(span) and PopBatch(span) claim and publish a whole run of slots with one atomic
+                 *   operation, the per-item cost of the synchronization almost disappears.
+                 * - Lock-free code is easy to get subtly wrong. Every item carries its producer and its sequence
+                 *   number, and every run checks that each item arrived exactly once and that each consumer saw the
+                 *   items of a producer in the order they were pushed; configure with -DCPP_REVIEW_THREAD_SANITIZER=ON to run it
+                 *   under ThreadSanitizer, which reports any data race the memory orderings fail to prevent.
+                 */
+
+                cout << "Lock-free ring buffers between threads!" << endl;
+
+                // What the rings replace: a MyBuffer used as a ring under a mutex
+                class MutexRingBuffer
+                {
+                private:
+                    BufferClass::MyBuffer<> slots;
+                    std::mutex mutex;
+                    std::size_t head = 0;
+                    std::size_t tail = 0;
+
+                public:
+                    explicit MutexRingBuffer(const unsigned int capacity) : slots(capacity) {}
+
+                    bool TryPush(const int value)
+                    {
+                        std::lock_guard lock(mutex);
+                        if (tail - head == slots.GetLength())
+                        {
+                            return false;
+                        }
+
+                        slots[static_cast<unsigned int>(tail++ % slots.GetLength())] = value;
+                        return true;
+                    }
+
+                    bool TryPop(int& value)
+                    {
+                        std::lock_guard lock(mutex);
+                        if (tail == head)
+                        {
+                            return false;
+                        }
+
+                        value = slots[static_cast<unsigned int>(head++ % slots.GetLength())];
+                        return true;
+                    }
+                };
+
+                constexpr unsigned int capacity = 1024;
+                constexpr int itemsPerProducer = 1'000'000;
+
+                struct RunResult
+                {
+                    double microseconds;
+                    bool exactlyOnceInOrder;
+                };
+
+                // Producer p pushes the items p * itemsPerProducer + 0, 1, 2, ..., consumers pop until everything has
+                // arrived. batch = 1 uses TryPush and TryPop, anything larger PushBatch and PopBatch. Each consumer
+                // checks that the sequence numbers of every producer increase and sets the bit of each item it
+                // receives in a shared bitmap: a bit that is already set is a duplicate, one still clear at the end
+                // a lost item.
+                auto runPairs = [](auto& ring, const int producers, const int consumers, const std::size_t batch)
+                {
+                    std::atomic<long long> received{0};
+                    const long long total = static_cast<long long>(producers) * itemsPerProducer;
+                    std::vector<std::atomic<std::uint64_t>> seen(static_cast<std::size_t>(total + 63) / 64);
+                    std::atomic<bool> exactlyOnceInOrder{true};
+                    std::vector<std::thread> threads;
+
+                    const auto start = std::chrono::steady_clock::now();
+                    for (int p = 0; p < producers; ++p)
+                    {
+                        threads.emplace_back([&ring, batch, p]()
+                        {
+                            std::vector<int> values(batch);
+                            for (int next = 0; next < itemsPerProducer;)
+                            {
+                                const std::size_t count = std::min<std::size_t>(batch, itemsPerProducer - next);
+                                std::iota(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(count),
+                                          p * itemsPerProducer + next);
+                                std::size_t pushed = 0;
+                                while (pushed < count)
+                                {
+                                    std::size_t done = 0;
+                                    if constexpr (requires { ring.PushBatch(std::span<const int>()); })
+                                    {
+                                        done = ring.PushBatch(std::span<const int>(values.data() + pushed,
+                                                                                   count - pushed));
+                                    }
+                                    else
+                                    {
+                                        done = ring.TryPush(values[pushed]) ? 1 : 0;
+                                    }
+
+                                    if (done == 0)
+                                    {
+                                        std::this_thread::yield(); // Full: let the consumers run
+                                    }
+                                    pushed += done;
+                                }
+                                next += static_cast<int>(count);
+                            }
+                        });
+                    }
+                    for (int c = 0; c < consumers; ++c)
+                    {
+                        threads.emplace_back([&ring, &received, &seen, &exactlyOnceInOrder, total, batch, producers]()
+                        {
+                            std::vector<int> values(batch);
+                            std::vector<int> lastSequence(static_cast<std::size_t>(producers), -1);
+                            bool inOrder = true;
+                            while (received.load(std::memory_order_relaxed) < total)
+                            {
+                                std::size_t count = 0;
+                                if constexpr (requires { ring.PopBatch(std::span<int>()); })
+                                {
+                                    count = ring.PopBatch(std::span<int>(values));
+                                }
+                                else
+                                {
+                                    count = ring.TryPop(values[0]) ? 1 : 0;
+                                }
+
+                                if (count == 0)
+                                {
+                                    std::this_thread::yield(); // Empty: let the producers run
+                                    continue;
+                                }
+
+                                for (std::size_t i = 0; i < count; ++i)
+                                {
+                                    const int producer = values[i] / itemsPerProducer;
+                                    const int sequence = values[i] % itemsPerProducer;
+                                    if (values[i] < 0 || producer >= producers)
+                                    {
+                                        inOrder = false; // Not an item any producer sent
+                                        continue;
+                                    }
+
+                                    int& last = lastSequence[static_cast<std::size_t>(producer)];
+                                    inOrder = inOrder && sequence > last;
+                                    last = sequence;
+                                    const auto item = static_cast<std::size_t>(values[i]);
+                                    const std::uint64_t bit = std::uint64_t{1} << (item % 64);
+                                    inOrder = inOrder &&
+                                        (seen[item / 64].fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+                                }
+                                received.fetch_add(static_cast<long long>(count), std::memory_order_relaxed);
+                            }
+                            if (!inOrder)
+                            {
+                                exactlyOnceInOrder = false;
+                            }
+                        });
+                    }
+                    for (std::thread& thread : threads)
+                    {
+                        thread.join();
+                    }
+                    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+                    // No duplicates were seen, so a full count with every bit set means no item went missing
+                    bool exactlyOnce = exactlyOnceInOrder && received.load() == total;
+                    for (std::size_t item = 0; exactlyOnce && item < static_cast<std::size_t>(total); ++item)
+                    {
+                        exactlyOnce = (seen[item / 64].load(std::memory_order_relaxed) >> (item % 64) & 1) != 0;
+                    }
+
+                    return RunResult{elapsed.count(), exactlyOnce};
+                };
+
+                auto report = [](const char* name, const int pairs, const RunResult& result)
+                {
+                    cout << name << ", " << pairs << " producer/consumer pair(s): "
+                        << pairs * static_cast<double>(itemsPerProducer) / result.microseconds << " M items/s"
+                        << (result.exactlyOnceInOrder ? "" : " (ITEMS LOST, DUPLICATED OR OUT OF ORDER)") << endl;
+                };
+
+                {
+                    MutexRingBuffer ring(capacity);
+                    report("MyBuffer + mutex", 1, runPairs(ring, 1, 1, 1));
+                }
+                {
+                    BufferClass::SpscRingBuffer<> ring(capacity);
+                    report("SpscRingBuffer, one item at a time", 1, runPairs(ring, 1, 1, 1));
+                }
+                {
+                    BufferClass::SpscRingBuffer<> ring(capacity);
+                    report("SpscRingBuffer, batches of 64", 1, runPairs(ring, 1, 1, 64));
+                }
+
+                const int maxPairs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency() / 2));
+                for (int pairs = 1; pairs <= std::max(2, maxPairs); pairs *= 2)
+                {
+                    BufferClass::MpmcRingBuffer<> ring(capacity);
+                    report("MpmcRingBuffer, batches of 64", pairs, runPairs(ring, pairs, pairs, 64));
+                }
+
+                // Latency: one value goes to the other thread and comes straight back, the round trip is timed
+                {
+                    constexpr int roundTrips = 100'000;
+                    BufferClass::SpscRingBuffer<> ping(16);
+                    BufferClass::SpscRingBuffer<> pong(16);
+
+                    std::thread echo([&ping, &pong]()
+                    {
+                        for (int received = 0, value = 0; received < roundTrips; ++received)
+                        {
+                            while (!ping.TryPop(value))
+                            {
+                                std::this_thread::yield();
+                            }
+                            while (!pong.TryPush(value))
+                            {
+                                std::this_thread::yield();
+                            }
+                        }
+                    });
+
+                    const double roundTripTime = Benchmark::MeasureMicroseconds([&ping, &pong]()
+                    {
+                        int value = 0;
+                        while (!ping.TryPush(1))
+                        {
+                            std::this_thread::yield();
+                        }
+                        while (!pong.TryPop(value))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }, roundTrips);
+                    echo.join();
+
+                    cout << "SpscRingBuffer round trip between two threads: " << roundTripTime * 1000.0 << " ns" << endl;
+                }
+
+                // Stress: four producers and four consumers through a ring of only 8 slots, so it is full and empty
+                // all the time
+                {
+                    BufferClass::MpmcRingBuffer<> ring(8);
+                    const RunResult stress = runPairs(ring, 4, 4, 3);
+                    cout << "MPMC stress with 4 producers and 4 consumers on 8 slots: ";
+                    if (stress.exactlyOnceInOrder)
+                    {
+                        cout << "every item arrived once, in order per producer" << endl;
+                    }
+                    else
+                    {
+                        cout << "FAILED, items were lost, duplicated or reordered" << endl;
+                    }
+                }
+            }
+            cout << "\n\n" << endl;
+
+            // Printing without iostream
+            {
+                /*
+                 * - cout << value << endl looks cheap, but every << goes through the stream's locale and sentry, and
+                 *   every endl flushes: one write system call per line. Printing a million numbers that way means a
+                 *   million system calls.
+                 * - FastOutput::OutputSink (Basics/FastOutput.h) formats numbers with std::to_chars, which needs no
+                 *   locale and no allocation, into one reusable 64 KiB block, and hands each full block to the
+                 *   operating system with a single write(2).
+                 * - DisplayBuffer of MyBuffer and BufferView prints through it, with an optional separator. It flushes
+                 *   cout first and its own block after, so the line still shows up in the right place between couts.
+                 */
+
+                cout << "Printing without iostream!" << endl;
+
+                BufferClass::MyBuffer<double> readings(4);
+                for (std::size_t i = 0; i < readings.GetLength(); ++i)
+                {
+                    readings[i] = 20.0 + 0.25 * static_cast<double>(i);
+                }
+                readings.DisplayBuffer();
+                readings.DisplayBuffer(", ");
+
+#ifdef MYBUFFER_HAS_MMAP
+                // Both sides print the same million ints to /dev/null, so only the formatting and the system calls count
+                constexpr std::size_t length = 1'000'000;
+                BufferClass::MyBuffer<> numbers(length);
+                const std::span<int> all = numbers.Span();
+                std::iota(all.begin(), all.end(), -static_cast<int>(length / 2));
+
+                std::ofstream stream("/dev/null");
+                const int nullDescriptor = ::open("/dev/null", O_WRONLY);
+                if (stream && nullDescriptor >= 0)
+                {
+                    const double endlTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        for (const int number : all)
+                        {
+                            stream << number << endl;
+                        }
+                    }, 1);
+                    const double streamTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        for (const int number : all)
+                        {
+                            stream << number << '\n';
+                        }
+                        stream.flush();
+                    }, 1);
+                    const double sinkTime = Benchmark::MeasureMicroseconds([&]()
+                    {
+                        FastOutput::OutputSink sink(nullDescriptor);
+                        sink.WriteElements(numbers.Data(), numbers.GetLength(), "\n", "");
+                    }, 1);
+
+                    cout << "A million ints with << endl: " << endlTime << " us, with << '\\n': " << streamTime
+                        << " us, through OutputSink: " << sinkTime << " us" << endl;
+                }
+
+                if (nullDescriptor >= 0)
+                {
+                    ::close(nullDescriptor);
+                }
+#endif
+            }
+            cout << "\n\n" << endl;
+
+            // Lifecycle counters instead of console logging
+            {
+                /*
+                 * - Printing from constructors is a good way to SEE the special member functions at work, but a
+                 *   stream insertion and a flush per construction costs far more than the construction itself, and it
+                 *   fills the output of every benchmark with noise.
+                 * - MyBuffer records its lifecycle in Lifecycle::Counters<MyBuffer> (LifecycleInstrumentation.h):
+                 *   constructions, copies, moves, destructions and heap bytes allocated.
+                 * - The counters only exist when the project is built with -DLIFECYCLE_INSTRUMENTATION=1. In the default
+                 *   build each recording call is an empty inline function behind if constexpr, so the compiler removes
+                 *   it completely: no branch, no atomic, no overhead.
+                 */
+
+                cout << "Lifecycle counters (instrumentation " << (Lifecycle::enabled ? "enabled" : "disabled") << ")!"
+                    << endl;
+
+                Lifecycle::Counters<BufferClass::MyBuffer<>>::Reset();
+                {
+                    BufferClass::MyBuffer buffer(5);
+                    BufferClass::MyBuffer buffer2(64);
+                    BufferClass::MyBuffer copy(buffer2);
+                    BufferClass::MyBuffer moved(std::move(copy));
+                    buffer = buffer2;
+                }
+
+                // Dump the counters as JSON, ready for a log line or a dashboard. All zeros when disabled.
+                cout << Lifecycle::ToJson({{"MyBuffer", Lifecycle::Counters<BufferClass::MyBuffer<>>::Take()}}) << endl;
+
+                // Churn benchmark: compare the result of a default build with a -DLIFECYCLE_INSTRUMENTATION=1 build
+                constexpr int churnRepetitions = 200000;
+                const double churnTime = Benchmark::MeasureMicroseconds([]()
+                {
+                    BufferClass::MyBuffer buffer(8);
+                    BufferClass::MyBuffer copy(buffer);
+                    BufferClass::MyBuffer moved(std::move(copy));
+                    buffer = std::move(moved);
+                }, churnRepetitions);
+
+                cout << "Construct, copy, move, move-assign and destroy: " << churnTime * 1000.0 << " ns per iteration"
+                    << endl;
+            }
+            cout << "\n\n" << endl;
+
             // User-defined literals
             {
                 /*
@@ -0,0 +1,230 @@
+//
+// Lock-free single-producer and multi-producer ring buffers on top of MyBuffer
+//
+
+#ifndef RING_BUFFERS_H_
+#define RING_BUFFERS_H_
+
+#include "BufferClass.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+
+namespace BufferClass
+{
+    // Head and tail indices written by different threads live on different cache lines, otherwise every write by
+    // one thread would invalidate the line the other one is spinning on (false sharing)
+    inline constexpr std::size_t kCacheLineSize = 64;
+
+    // Bounded single-producer single-consumer queue on a MyBuffer<T>. Lock-free and wait-free: the producer only
+    // writes the tail, the consumer only writes the head, and each side keeps a cached copy of the other's index so it
+    // only reads the shared one when the cached value says the ring is full (or empty).
+    // Exactly one thread may push and exactly one thread may pop.
+    template<typename T = int>
+    class SpscRingBuffer
+    {
+    public:
+        // The capacity is rounded up to a power of two so that a position maps to its slot with a mask
+        explicit SpscRingBuffer(const unsigned int capacity)
+            : mSlots(std::bit_ceil(std::max(capacity, 2u))), mMask(mSlots.GetLength() - 1)
+        {
+        }
+
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        std::size_t GetCapacity() const { return mMask + 1; }
+
+        // Only exact when neither side is running. The head is read first: it never passes the tail, so the tail read
+        // after it is at least as far along and the difference cannot wrap around.
+        std::size_t GetSizeApprox() const
+        {
+            const std::size_t head = mHead.load(std::memory_order_acquire);
+            const std::size_t tail = mTail.load(std::memory_order_acquire);
+            return std::min(tail - head, GetCapacity());
+        }
+
+        bool TryPush(const T& value) { return PushBatch(std::span<const T>(&value, 1)) == 1; }
+        bool TryPop(T& value) { return PopBatch(std::span<T>(&value, 1)) == 1; }
+
+        // Pushes as many values as fit, in order, and publishes them with a single release store. Returns how many.
+        std::size_t PushBatch(const std::span<const T> values)
+        {
+            const std::size_t tail = mTail.load(std::memory_order_relaxed);
+            if (GetCapacity() - (tail - mCachedHead) < values.size())
+            {
+                mCachedHead = mHead.load(std::memory_order_acquire);
+            }
+
+            const std::size_t count = std::min(values.size(), GetCapacity() - (tail - mCachedHead));
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            // At most two contiguous pieces: up to the end of the slots, then from the start
+            const std::size_t start = tail & mMask;
+            const std::size_t first = std::min(count, GetCapacity() - start);
+            std::copy_n(values.data(), first, mSlots.Data() + start);
+            std::copy_n(values.data() + first, count - first, mSlots.Data());
+
+            mTail.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        // Pops up to values.size() values into values, frees their slots with a single release store
+        std::size_t PopBatch(const std::span<T> values)
+        {
+            const std::size_t head = mHead.load(std::memory_order_relaxed);
+            if (mCachedTail - head < values.size())
+            {
+                mCachedTail = mTail.load(std::memory_order_acquire);
+            }
+
+            const std::size_t count = std::min(values.size(), mCachedTail - head);
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            const std::size_t start = head & mMask;
+            const std::size_t first = std::min(count, GetCapacity() - start);
+            std::copy_n(mSlots.Data() + start, first, values.data());
+            std::copy_n(mSlots.Data(), count - first, values.data() + first);
+
+            mHead.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+    private:
+        MyBuffer<T> mSlots;
+        std::size_t mMask;
+
+        // Consumer side: the head it writes and its copy of the tail
+        alignas(kCacheLineSize) std::atomic<std::size_t> mHead{0};
+        std::size_t mCachedTail = 0;
+
+        // Producer side: the tail it writes and its copy of the head
+        alignas(kCacheLineSize) std::atomic<std::size_t> mTail{0};
+        std::size_t mCachedHead = 0;
+    };
+
+    // Bounded multi-producer multi-consumer queue on a MyBuffer<T> (Dmitry Vyukov's design). Every slot carries a
+    // sequence number that says whose turn it is: position p is free for the producer of p when it equals p, and
+    // holds a value for the consumer of p when it equals p + 1. Producers and consumers claim positions with a
+    // compare-and-swap on their own index and never wait for each other's locks.
+    template<typename T = int>
+    class MpmcRingBuffer
+    {
+    public:
+        explicit MpmcRingBuffer(const unsigned int capacity)
+            : mSlots(std::bit_ceil(std::max(capacity, 2u))), mSequences(mSlots.GetLength()),
+              mMask(mSlots.GetLength() - 1)
+        {
+            for (std::size_t i = 0; i <= mMask; ++i)
+            {
+                mSequences[static_cast<unsigned int>(i)].store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+        MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+        std::size_t GetCapacity() const { return mMask + 1; }
+
+        bool TryPush(const T& value) { return PushBatch(std::span<const T>(&value, 1)) == 1; }
+        bool TryPop(T& value) { return PopBatch(std::span<T>(&value, 1)) == 1; }
+
+        // Claims up to values.size() consecutive free positions with one compare-and-swap, then fills them. Returns
+        // how many values were pushed, 0 when the ring is full.
+        std::size_t PushBatch(const std::span<const T> values)
+        {
+            std::size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+            const std::size_t count = Claim(mEnqueuePosition, position, values.size(), 0);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const std::size_t slot = (position + i) & mMask;
+                mSlots[static_cast<unsigned int>(slot)] = values[i];
+                Sequence(slot).store(position + i + 1, std::memory_order_release);
+            }
+
+            return count;
+        }
+
+        // Claims up to values.size() consecutive filled positions, copies them out and hands the slots back to the
+        // producers of the next lap. Returns how many values were popped, 0 when the ring is empty.
+        std::size_t PopBatch(const std::span<T> values)
+        {
+            std::size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+            const std::size_t count = Claim(mDequeuePosition, position, values.size(), 1);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const std::size_t slot = (position + i) & mMask;
+                values[i] = mSlots[static_cast<unsigned int>(slot)];
+                Sequence(slot).store(position + i + GetCapacity(), std::memory_order_release);
+            }
+
+            return count;
+        }
+
+    private:
+        MyBuffer<T> mSlots;
+        MyBuffer<std::atomic<std::size_t>> mSequences;
+        std::size_t mMask;
+
+        alignas(kCacheLineSize) std::atomic<std::size_t> mEnqueuePosition{0};
+        alignas(kCacheLineSize) std::atomic<std::size_t> mDequeuePosition{0};
+
+        std::atomic<std::size_t>& Sequence(const std::size_t slot)
+        {
+            return mSequences[static_cast<unsigned int>(slot)];
+        }
+
+        // Counts the positions from position on whose sequence is position + i + lag (ready for this side), then takes
+        // them with a compare-and-swap on index. On return position is the first claimed position.
+        std::size_t Claim(std::atomic<std::size_t>& index, std::size_t& position, const std::size_t wanted,
+                          const std::size_t lag)
+        {
+            while (true)
+            {
+                std::size_t ready = 0;
+                std::ptrdiff_t difference = 0;
+                while (ready < wanted)
+                {
+                    const std::size_t sequence = Sequence((position + ready) & mMask).load(std::memory_order_acquire);
+                    difference = static_cast<std::ptrdiff_t>(sequence - (position + ready + lag));
+                    if (difference != 0)
+                    {
+                        break;
+                    }
+
+                    ++ready;
+                }
+
+                if (ready == 0)
+                {
+                    if (difference < 0)
+                    {
+                        return 0; // Full for producers, empty for consumers
+                    }
+
+                    position = index.load(std::memory_order_relaxed); // Another thread took this position first
+                    continue;
+                }
+
+                // On failure compare_exchange_weak reloads position and the scan starts again from there
+                if (index.compare_exchange_weak(position, position + ready, std::memory_order_relaxed))
+                {
+                    return ready;
+                }
+            }
+        }
+    };
+}
+
+#endif